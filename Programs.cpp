@@ -1,4 +1,14 @@
 #include "Programs.h"
+#include "RISCV_CPU.h"
+#include "RISCV_CheckpointFile.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <string>
 
 void Run_fibonacciProgram(std::vector<uint8_t>& memoryBytes)
 {
@@ -18,4 +28,739 @@ void Run_fibonacciProgram(std::vector<uint8_t>& memoryBytes)
         memoryBytes.push_back((inst >> 16) & 0xFF);
         memoryBytes.push_back((inst >> 24) & 0xFF);
     }
-}
\ No newline at end of file
+}
+
+// --- Workload corpus ---
+
+namespace {
+    // ABI register names for the kernels below
+    enum GuestReg : uint32_t {
+        ZERO, RA, SP, GP, TP, T0, T1, T2, S0, S1, A0, A1, A2, A3, A4, A5, A6, A7,
+        S2, S3, S4, S5, S6, S7, S8, S9, S10, S11, T3, T4, T5, T6
+    };
+
+    const int32_t STACK_TOP = 0xFFFF0;
+
+    // Just enough RV32I assembler to keep the kernels readable. Branches, jumps
+    // and LA name labels, which are resolved when the program is finished.
+    // The image is loaded at address 0, so label offsets are addresses.
+    class KernelAssembler {
+    public:
+        void Label(const std::string& name) { Labels[name] = Here(); }
+        uint32_t Address(const std::string& name) const { return Labels.at(name); }
+
+        // --- RV32I ---
+        void LUI(uint32_t rd, uint32_t imm) { Emit((imm & 0xFFFFF000) | (rd << 7) | 0x37); }
+        void JAL(uint32_t rd, const std::string& target) { AddFixup(FIX_JUMP, target); Emit((rd << 7) | 0x6F); }
+        void JALR(uint32_t rd, uint32_t rs1, int32_t imm) { EmitI(0x67, 0x0, rd, rs1, imm); }
+
+        void BEQ(uint32_t rs1, uint32_t rs2, const std::string& target)  { EmitBranch(0x0, rs1, rs2, target); }
+        void BNE(uint32_t rs1, uint32_t rs2, const std::string& target)  { EmitBranch(0x1, rs1, rs2, target); }
+        void BLT(uint32_t rs1, uint32_t rs2, const std::string& target)  { EmitBranch(0x4, rs1, rs2, target); }
+        void BGE(uint32_t rs1, uint32_t rs2, const std::string& target)  { EmitBranch(0x5, rs1, rs2, target); }
+        void BLTU(uint32_t rs1, uint32_t rs2, const std::string& target) { EmitBranch(0x6, rs1, rs2, target); }
+        void BGEU(uint32_t rs1, uint32_t rs2, const std::string& target) { EmitBranch(0x7, rs1, rs2, target); }
+
+        // Loads: rd = mem[rs1 + imm]; stores: mem[rs1 + imm] = rs2
+        void LW(uint32_t rd, uint32_t rs1, int32_t imm)  { EmitI(0x03, 0x2, rd, rs1, imm); }
+        void LBU(uint32_t rd, uint32_t rs1, int32_t imm) { EmitI(0x03, 0x4, rd, rs1, imm); }
+        void SB(uint32_t rs2, uint32_t rs1, int32_t imm) { EmitS(0x0, rs2, rs1, imm); }
+        void SW(uint32_t rs2, uint32_t rs1, int32_t imm) { EmitS(0x2, rs2, rs1, imm); }
+
+        void ADDI(uint32_t rd, uint32_t rs1, int32_t imm)  { EmitI(0x13, 0x0, rd, rs1, imm); }
+        void SLTIU(uint32_t rd, uint32_t rs1, int32_t imm) { EmitI(0x13, 0x3, rd, rs1, imm); }
+        void XORI(uint32_t rd, uint32_t rs1, int32_t imm)  { EmitI(0x13, 0x4, rd, rs1, imm); }
+        void ANDI(uint32_t rd, uint32_t rs1, int32_t imm)  { EmitI(0x13, 0x7, rd, rs1, imm); }
+        void SLLI(uint32_t rd, uint32_t rs1, uint32_t shamt) { EmitI(0x13, 0x1, rd, rs1, (int32_t)(shamt & 0x1F)); }
+        void SRLI(uint32_t rd, uint32_t rs1, uint32_t shamt) { EmitI(0x13, 0x5, rd, rs1, (int32_t)(shamt & 0x1F)); }
+
+        void ADD(uint32_t rd, uint32_t rs1, uint32_t rs2) { EmitR(0x00, 0x0, rd, rs1, rs2); }
+        void SUB(uint32_t rd, uint32_t rs1, uint32_t rs2) { EmitR(0x20, 0x0, rd, rs1, rs2); }
+        void XOR(uint32_t rd, uint32_t rs1, uint32_t rs2) { EmitR(0x00, 0x4, rd, rs1, rs2); }
+        void OR(uint32_t rd, uint32_t rs1, uint32_t rs2)  { EmitR(0x00, 0x6, rd, rs1, rs2); }
+        void AND(uint32_t rd, uint32_t rs1, uint32_t rs2) { EmitR(0x00, 0x7, rd, rs1, rs2); }
+
+        void ECALL() { Emit(0x00000073); }
+
+        // --- Pseudo-instructions ---
+        void LI(uint32_t rd, int32_t value) {
+            if (value >= -2048 && value < 2048) {
+                ADDI(rd, ZERO, value);
+                return;
+            }
+            // LUI takes the upper bits rounded so that the sign-extended low part adds back
+            uint32_t upper = ((uint32_t)value + 0x800) & 0xFFFFF000;
+            LUI(rd, upper);
+            int32_t lower = (int32_t)((uint32_t)value - upper);
+            if (lower != 0) ADDI(rd, rd, lower);
+        }
+        void LA(uint32_t rd, const std::string& target) {
+            AddFixup(FIX_ADDRESS, target);
+            LUI(rd, 0);
+            ADDI(rd, rd, 0);
+        }
+        void MV(uint32_t rd, uint32_t rs) { ADDI(rd, rs, 0); }
+        void J(const std::string& target) { JAL(ZERO, target); }
+        void CALL(const std::string& target) { JAL(RA, target); }
+        void RET() { JALR(ZERO, RA, 0); }
+        void BEQZ(uint32_t rs, const std::string& target) { BEQ(rs, ZERO, target); }
+        void BNEZ(uint32_t rs, const std::string& target) { BNE(rs, ZERO, target); }
+
+        // xorshift32 step on 'x' (the kernels make their own input data with it)
+        void XORSHIFT(uint32_t x, uint32_t tmp) {
+            SLLI(tmp, x, 13); XOR(x, x, tmp);
+            SRLI(tmp, x, 17); XOR(x, x, tmp);
+            SLLI(tmp, x, 5);  XOR(x, x, tmp);
+        }
+
+        // --- Data ---
+        void Word(uint32_t value) { Emit(value); }
+        void Ascii(const char* text) { // Zero-terminated, padded to a word
+            std::string bytes(text);
+            bytes.resize((bytes.size() + 4) & ~(size_t)3, '\0');
+            for (size_t i = 0; i < bytes.size(); i += 4) {
+                Emit((uint32_t)(uint8_t)bytes[i] | ((uint32_t)(uint8_t)bytes[i + 1] << 8) |
+                     ((uint32_t)(uint8_t)bytes[i + 2] << 16) | ((uint32_t)(uint8_t)bytes[i + 3] << 24));
+            }
+        }
+
+        // Resolves the labels and appends the image (little endian)
+        void Finish(std::vector<uint8_t>& memoryBytes) {
+            for (const Fixup& fixup : Fixups) {
+                auto found = Labels.find(fixup.Target);
+                if (found == Labels.end()) {
+                    std::cerr << "Error: Undefined Label " << fixup.Target << std::endl;
+                    continue;
+                }
+                uint32_t& inst = Code[fixup.Index];
+                uint32_t offset = found->second - fixup.Index * 4;
+                switch (fixup.Kind) {
+                    case FIX_BRANCH:
+                        inst |= ((offset >> 12) & 0x1) << 31 | ((offset >> 5) & 0x3F) << 25 |
+                                ((offset >> 1) & 0xF) << 8 | ((offset >> 11) & 0x1) << 7;
+                        break;
+                    case FIX_JUMP:
+                        inst |= ((offset >> 20) & 0x1) << 31 | ((offset >> 1) & 0x3FF) << 21 |
+                                ((offset >> 11) & 0x1) << 20 | ((offset >> 12) & 0xFF) << 12;
+                        break;
+                    case FIX_ADDRESS: {
+                        uint32_t address = found->second;
+                        uint32_t upper = (address + 0x800) & 0xFFFFF000;
+                        inst |= upper;
+                        Code[fixup.Index + 1] |= ((address - upper) & 0xFFF) << 20;
+                        break;
+                    }
+                }
+            }
+
+            for (uint32_t inst : Code) {
+                memoryBytes.push_back(inst & 0xFF);
+                memoryBytes.push_back((inst >> 8) & 0xFF);
+                memoryBytes.push_back((inst >> 16) & 0xFF);
+                memoryBytes.push_back((inst >> 24) & 0xFF);
+            }
+        }
+
+    private:
+        enum FixupKind { FIX_BRANCH, FIX_JUMP, FIX_ADDRESS };
+        struct Fixup {
+            FixupKind Kind;
+            size_t Index;
+            std::string Target;
+        };
+
+        uint32_t Here() const { return (uint32_t)Code.size() * 4; }
+        void Emit(uint32_t inst) { Code.push_back(inst); }
+        void AddFixup(FixupKind kind, const std::string& target) { Fixups.push_back({ kind, Code.size(), target }); }
+
+        void EmitR(uint32_t funct7, uint32_t funct3, uint32_t rd, uint32_t rs1, uint32_t rs2) {
+            Emit((funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | 0x33);
+        }
+        void EmitI(uint32_t opcode, uint32_t funct3, uint32_t rd, uint32_t rs1, int32_t imm) {
+            Emit(((uint32_t)imm << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | opcode);
+        }
+        void EmitS(uint32_t funct3, uint32_t rs2, uint32_t rs1, int32_t imm) {
+            uint32_t u = (uint32_t)imm;
+            Emit(((u >> 5) & 0x7F) << 25 | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (u & 0x1F) << 7 | 0x23);
+        }
+        void EmitBranch(uint32_t funct3, uint32_t rs1, uint32_t rs2, const std::string& target) {
+            AddFixup(FIX_BRANCH, target);
+            Emit((rs2 << 20) | (rs1 << 15) | (funct3 << 12) | 0x63);
+        }
+
+        std::vector<uint32_t> Code;
+        std::map<std::string, uint32_t> Labels;
+        std::vector<Fixup> Fixups;
+    };
+}
+
+void Run_memcpyProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t SRC = 0x20000, DST = 0x30000, BYTES = 0x4000, PASSES = 32;
+    KernelAssembler a;
+    a.LI(S0, SRC); a.LI(S1, DST); a.LI(S2, BYTES); a.LI(S3, PASSES); a.LI(S4, 0);
+
+    a.Label("pass");
+    // memset(src, 0x40 + pass, BYTES), four words per iteration
+    a.ADDI(T0, S3, 0x40); a.SLLI(T1, T0, 8); a.OR(T0, T0, T1); a.SLLI(T1, T0, 16); a.OR(T0, T0, T1);
+    a.MV(T2, S0); a.ADD(T3, S0, S2);
+    a.Label("memset");
+    a.SW(T0, T2, 0); a.SW(T0, T2, 4); a.SW(T0, T2, 8); a.SW(T0, T2, 12);
+    a.ADDI(T2, T2, 16); a.BLTU(T2, T3, "memset");
+
+    // A byte counter every 64 bytes, so the copies move varied data
+    a.LI(T2, 0); a.MV(T4, S0); a.LI(T5, 256);
+    a.Label("sprinkle");
+    a.SB(T2, T4, 0); a.ADDI(T4, T4, 64); a.ADDI(T2, T2, 1); a.BLT(T2, T5, "sprinkle");
+
+    // Word memcpy(dst, src, BYTES), unrolled four times
+    a.MV(T2, S0); a.MV(T4, S1); a.ADD(T3, S0, S2);
+    a.Label("copy_words");
+    a.LW(T5, T2, 0); a.LW(T6, T2, 4); a.LW(A1, T2, 8); a.LW(A2, T2, 12);
+    a.SW(T5, T4, 0); a.SW(T6, T4, 4); a.SW(A1, T4, 8); a.SW(A2, T4, 12);
+    a.ADDI(T2, T2, 16); a.ADDI(T4, T4, 16); a.BLTU(T2, T3, "copy_words");
+
+    // Byte memcpy of 1000 bytes between misaligned addresses (src + 3 -> dst + BYTES + 1)
+    a.ADDI(T2, S0, 3); a.ADD(T4, S1, S2); a.ADDI(T4, T4, 1); a.ADDI(T6, T2, 1000);
+    a.Label("copy_bytes");
+    a.LBU(T5, T2, 0); a.SB(T5, T4, 0); a.ADDI(T2, T2, 1); a.ADDI(T4, T4, 1); a.BLTU(T2, T6, "copy_bytes");
+
+    // Checksum the destination (add, rotate left by one)
+    a.MV(T2, S1); a.ADD(T3, S1, S2);
+    a.Label("checksum");
+    a.LW(T5, T2, 0); a.ADD(S4, S4, T5); a.SLLI(T6, S4, 1); a.SRLI(A1, S4, 31); a.OR(S4, T6, A1);
+    a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "checksum");
+
+    a.ADDI(S3, S3, -1); a.BNEZ(S3, "pass");
+    a.MV(A0, S4);
+    a.ECALL();
+    a.Finish(memoryBytes);
+}
+
+void Run_matrixMultiplyProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t N = 24, MAT_A = 0x20000, MAT_B = 0x21000, MAT_C = 0x22000;
+    KernelAssembler a;
+    a.LI(SP, STACK_TOP);
+    a.LI(S0, MAT_A); a.LI(S1, MAT_B); a.LI(S2, MAT_C); a.LI(S3, N); a.LI(S11, 0);
+
+    // A and B get bytes from xorshift (small values keep the shift-add multiply short)
+    a.LI(T0, 0x12345678);
+    a.MV(T2, S0); a.LI(T3, MAT_A + N * N * 4);
+    a.Label("fill_a");
+    a.XORSHIFT(T0, T1); a.ANDI(T4, T0, 0xFF); a.SW(T4, T2, 0); a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "fill_a");
+    a.MV(T2, S1); a.LI(T3, MAT_B + N * N * 4);
+    a.Label("fill_b");
+    a.XORSHIFT(T0, T1); a.ANDI(T4, T0, 0xFF); a.SW(T4, T2, 0); a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "fill_b");
+
+    // C[i][j] = sum over k of A[i][k] * B[k][j]
+    a.MV(S4, S0);  // &A[i][0]
+    a.MV(S9, S2);  // &C[i][j]
+    a.LI(S10, 0);  // i
+    a.Label("row");
+    a.LI(S5, 0);   // j
+    a.Label("col");
+    a.MV(T2, S4); a.SLLI(T3, S5, 2); a.ADD(T3, T3, S1); // &A[i][k], &B[k][j]
+    a.LI(S6, 0); a.LI(S7, 0);                           // k, sum
+    a.Label("dot");
+    a.LW(A0, T2, 0); a.LW(A1, T3, 0); a.CALL("mul"); a.ADD(S7, S7, A0);
+    a.ADDI(T2, T2, 4); a.ADDI(T3, T3, N * 4); a.ADDI(S6, S6, 1); a.BLT(S6, S3, "dot");
+    a.SW(S7, S9, 0); a.ADDI(S9, S9, 4); a.ADD(S11, S11, S7);
+    a.ADDI(S5, S5, 1); a.BLT(S5, S3, "col");
+    a.ADDI(S4, S4, N * 4); a.ADDI(S10, S10, 1); a.BLT(S10, S3, "row");
+
+    a.MV(A0, S11);
+    a.ECALL();
+
+    // a0 = a0 * a1 by shift and add (clobbers a1-a3)
+    a.Label("mul");
+    a.LI(A2, 0);
+    a.Label("mul_loop");
+    a.ANDI(A3, A1, 1); a.BEQZ(A3, "mul_skip"); a.ADD(A2, A2, A0);
+    a.Label("mul_skip");
+    a.SLLI(A0, A0, 1); a.SRLI(A1, A1, 1); a.BNEZ(A1, "mul_loop");
+    a.MV(A0, A2);
+    a.RET();
+    a.Finish(memoryBytes);
+}
+
+void Run_quicksortProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t ARRAY = 0x20000, COUNT = 8192;
+    KernelAssembler a;
+    a.LI(SP, STACK_TOP);
+    a.LI(S0, ARRAY); a.LI(S1, COUNT);
+
+    // Random signed words
+    a.LI(T0, 0x2545F491);
+    a.MV(T2, S0); a.SLLI(T3, S1, 2); a.ADD(T3, T3, S0);
+    a.Label("fill");
+    a.XORSHIFT(T0, T1); a.SW(T0, T2, 0); a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "fill");
+
+    a.MV(A0, S0); a.ADDI(A1, T3, -4); a.CALL("qsort");
+
+    // a0 = checksum, a1 = neighbours out of order (0 if sorted)
+    a.MV(T2, S0); a.SLLI(T3, S1, 2); a.ADD(T3, T3, S0); a.ADDI(T3, T3, -4);
+    a.LI(S4, 0); a.LI(S5, 0);
+    a.Label("verify");
+    a.LW(T4, T2, 0); a.LW(T5, T2, 4); a.BGE(T5, T4, "in_order"); a.ADDI(S5, S5, 1);
+    a.Label("in_order");
+    a.ADD(S4, S4, T4); a.SLLI(T6, S4, 1); a.SRLI(A2, S4, 31); a.OR(S4, T6, A2);
+    a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "verify");
+    a.MV(A0, S4); a.MV(A1, S5);
+    a.ECALL();
+
+    // qsort(a0 = &first, a1 = &last), Lomuto partition around the last element
+    a.Label("qsort");
+    a.BGEU(A0, A1, "qsort_done");
+    a.ADDI(SP, SP, -16); a.SW(RA, SP, 12); a.SW(S0, SP, 8); a.SW(S1, SP, 4); a.SW(S2, SP, 0);
+    a.MV(S0, A0); a.MV(S1, A1);
+    a.LW(T0, S1, 0);                   // pivot
+    a.ADDI(T1, S0, -4);                // i
+    a.MV(T2, S0);                      // j
+    a.Label("partition");
+    a.BGEU(T2, S1, "partition_done");
+    a.LW(T3, T2, 0); a.BGE(T3, T0, "no_swap");
+    a.ADDI(T1, T1, 4); a.LW(T4, T1, 0); a.SW(T3, T1, 0); a.SW(T4, T2, 0);
+    a.Label("no_swap");
+    a.ADDI(T2, T2, 4); a.J("partition");
+    a.Label("partition_done");
+    a.ADDI(T1, T1, 4); a.LW(T4, T1, 0); a.LW(T3, S1, 0); a.SW(T3, T1, 0); a.SW(T4, S1, 0);
+    a.MV(S2, T1);                      // Pivot's final place
+    a.MV(A0, S0); a.ADDI(A1, S2, -4); a.CALL("qsort");
+    a.ADDI(A0, S2, 4); a.MV(A1, S1); a.CALL("qsort");
+    a.LW(RA, SP, 12); a.LW(S0, SP, 8); a.LW(S1, SP, 4); a.LW(S2, SP, 0); a.ADDI(SP, SP, 16);
+    a.Label("qsort_done");
+    a.RET();
+    a.Finish(memoryBytes);
+}
+
+void Run_crc32Program(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t TABLE = 0x20000, BUFFER = 0x21000, BYTES = 0x10000;
+    KernelAssembler a;
+    a.LI(S0, TABLE); a.LI(S1, BUFFER); a.LI(S2, BYTES); a.LI(S3, (int32_t)0xEDB88320);
+
+    // table[i] = i after eight steps of "shift right, xor the polynomial if bit 0 was set"
+    a.LI(T0, 0); a.MV(T2, S0); a.LI(T5, 256);
+    a.Label("table");
+    a.MV(T1, T0); a.LI(T3, 8);
+    a.Label("table_bit");
+    a.ANDI(T4, T1, 1); a.SRLI(T1, T1, 1); a.BEQZ(T4, "table_no_xor"); a.XOR(T1, T1, S3);
+    a.Label("table_no_xor");
+    a.ADDI(T3, T3, -1); a.BNEZ(T3, "table_bit");
+    a.SW(T1, T2, 0); a.ADDI(T2, T2, 4); a.ADDI(T0, T0, 1); a.BLT(T0, T5, "table");
+
+    // Message: xorshift words
+    a.LI(T0, 0x9E3779B9);
+    a.MV(T2, S1); a.ADD(T3, S1, S2);
+    a.Label("fill");
+    a.XORSHIFT(T0, T1); a.SW(T0, T2, 0); a.ADDI(T2, T2, 4); a.BLTU(T2, T3, "fill");
+
+    // crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8), starting from ~0 and inverted at the end
+    a.LI(A0, -1); a.MV(T2, S1);
+    a.Label("crc");
+    a.LBU(T4, T2, 0); a.XOR(T5, A0, T4); a.ANDI(T5, T5, 0xFF); a.SLLI(T5, T5, 2); a.ADD(T5, T5, S0);
+    a.LW(T5, T5, 0); a.SRLI(A0, A0, 8); a.XOR(A0, A0, T5);
+    a.ADDI(T2, T2, 1); a.BLTU(T2, T3, "crc");
+    a.XORI(A0, A0, -1);
+    a.ECALL();
+    a.Finish(memoryBytes);
+}
+
+void Run_dhrystoneProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t STR_2 = 0x20000, REC_2 = 0x20100, ARR_1 = 0x20200, ARR_2 = 0x20400, ITERATIONS = 4000;
+    KernelAssembler a;
+    a.LI(SP, STACK_TOP);
+    a.LA(S0, "str_1"); a.LI(S1, STR_2); a.LA(S2, "rec_1"); a.LI(S3, REC_2); a.LI(S4, ARR_1); a.LI(S5, ARR_2);
+    a.LI(S6, ITERATIONS); a.LI(S7, 0); a.LI(S8, 0); // Counter, checksum, string mismatches
+
+    a.Label("iteration");
+    // Record assignment, string copy and compare
+    a.MV(A0, S3); a.MV(A1, S2); a.LI(A2, 8); a.CALL("copy_words");
+    a.MV(A0, S1); a.MV(A1, S0); a.CALL("strcpy");
+    a.MV(A0, S1); a.MV(A1, S0); a.CALL("strcmp"); a.BEQZ(A0, "strings_equal"); a.ADDI(S8, S8, 1);
+    a.Label("strings_equal");
+
+    // Integer mix: int_1 = counter & 15, int_2 = int_1 + 3, int_3 = proc_7(int_1, int_2)
+    a.ANDI(S9, S6, 15); a.ADDI(S10, S9, 3);
+    a.MV(A0, S9); a.MV(A1, S10); a.CALL("proc_7"); a.MV(S11, A0);
+
+    // Array work: arr_1[int_1] = int_3, arr_1[int_1 + 1] = arr_1[int_1], arr_1[int_1 + 30] = int_1,
+    // arr_2[int_1][int_1]++, arr_2[int_1 + 20][int_1] = arr_1[int_1]  (64 x 64 words)
+    a.SLLI(T0, S9, 2); a.ADD(T0, T0, S4); a.SW(S11, T0, 0); a.LW(T1, T0, 0); a.SW(T1, T0, 4); a.SW(S9, T0, 120);
+    a.SLLI(T2, S9, 8); a.SLLI(T3, S9, 2); a.ADD(T2, T2, T3); a.ADD(T2, T2, S5);
+    a.LW(T4, T2, 0); a.ADDI(T4, T4, 1); a.SW(T4, T2, 0);
+    a.LI(T5, 20 * 256); a.ADD(T5, T5, T2); a.SW(T1, T5, 0);
+
+    // Character compare of two neighbouring characters of str_2
+    a.ADD(T0, S1, S9); a.LBU(A0, T0, 0); a.LBU(A1, T0, 1); a.CALL("func_1"); a.ADD(S7, S7, A0);
+
+    // Enumeration switch on int_1 & 3
+    a.ANDI(T0, S9, 3);
+    a.BEQZ(T0, "case_0");
+    a.ADDI(T1, T0, -1); a.BEQZ(T1, "case_1");
+    a.ADDI(T1, T0, -2); a.BEQZ(T1, "case_2");
+    a.ADDI(S7, S7, 7); a.J("case_end");
+    a.Label("case_0");
+    a.ADDI(S7, S7, 1); a.J("case_end");
+    a.Label("case_1");
+    a.ADDI(S7, S7, 3); a.J("case_end");
+    a.Label("case_2");
+    a.XORI(S7, S7, 0x55);
+    a.Label("case_end");
+
+    // Fold the record and integer state into the checksum (rotate left by three)
+    a.LW(T0, S3, 4); a.ADD(S7, S7, T0); a.ADD(S7, S7, S11);
+    a.SLLI(T1, S7, 3); a.SRLI(T2, S7, 29); a.OR(S7, T1, T2);
+    a.ADDI(S6, S6, -1); a.BNEZ(S6, "iteration");
+
+    a.MV(A0, S7); a.MV(A1, S8);
+    a.ECALL();
+
+    // copy_words(a0 = dst, a1 = src, a2 = count)
+    a.Label("copy_words");
+    a.LW(A3, A1, 0); a.SW(A3, A0, 0); a.ADDI(A0, A0, 4); a.ADDI(A1, A1, 4); a.ADDI(A2, A2, -1); a.BNEZ(A2, "copy_words");
+    a.RET();
+    // strcpy(a0 = dst, a1 = src)
+    a.Label("strcpy");
+    a.LBU(A2, A1, 0); a.SB(A2, A0, 0); a.ADDI(A0, A0, 1); a.ADDI(A1, A1, 1); a.BNEZ(A2, "strcpy");
+    a.RET();
+    // strcmp(a0, a1): 0 if equal, else the difference of the first differing characters
+    a.Label("strcmp");
+    a.LBU(A2, A0, 0); a.LBU(A3, A1, 0); a.BNE(A2, A3, "strcmp_differ"); a.BEQZ(A2, "strcmp_equal");
+    a.ADDI(A0, A0, 1); a.ADDI(A1, A1, 1); a.J("strcmp");
+    a.Label("strcmp_differ");
+    a.SUB(A0, A2, A3); a.RET();
+    a.Label("strcmp_equal");
+    a.LI(A0, 0); a.RET();
+    // proc_7(a0, a1) = a0 + a1 + 2
+    a.Label("proc_7");
+    a.ADDI(A0, A0, 2); a.ADD(A0, A0, A1); a.RET();
+    // func_1(a0, a1) = 1 if the characters match, else 0
+    a.Label("func_1");
+    a.BNE(A0, A1, "func_1_differ"); a.LI(A0, 1); a.RET();
+    a.Label("func_1_differ");
+    a.LI(A0, 0); a.RET();
+
+    // Constant data
+    a.Label("str_1");
+    a.Ascii("DHRYSTONE PROGRAM, 1'ST STRING");
+    a.Label("rec_1");
+    for (uint32_t i = 0; i < 8; i++) a.Word(0x1000 + i * 0x111);
+    a.Finish(memoryBytes);
+}
+
+void Run_pointerChaseProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t NODES = 0x40000, COUNT = 16384, STEPS = 300000;
+    KernelAssembler a;
+    a.LI(S0, NODES); a.LI(S1, 0); a.LI(S2, COUNT); a.LI(S3, 0x1F3B); a.LI(S4, COUNT - 1);
+
+    // 16-byte nodes { next, value }. next = (725 * i + 0x1F3B) mod COUNT is a full-period
+    // LCG (725 = 1 mod 4, odd increment), so the nodes form a single ring in scattered order.
+    a.Label("build");
+    a.SLLI(T0, S1, 9); a.SLLI(T1, S1, 7); a.ADD(T0, T0, T1); a.SLLI(T1, S1, 6); a.ADD(T0, T0, T1);
+    a.SLLI(T1, S1, 4); a.ADD(T0, T0, T1); a.SLLI(T1, S1, 2); a.ADD(T0, T0, T1); a.ADD(T0, T0, S1); // 725 * i
+    a.ADD(T0, T0, S3); a.AND(T0, T0, S4);
+    a.SLLI(T0, T0, 4); a.ADD(T0, T0, S0);
+    a.SLLI(T2, S1, 4); a.ADD(T2, T2, S0);
+    a.SW(T0, T2, 0); a.XORI(T3, S1, 0x5A5); a.SW(T3, T2, 4);
+    a.ADDI(S1, S1, 1); a.BLT(S1, S2, "build");
+
+    // Walk the ring: every load depends on the previous one
+    a.MV(T0, S0); a.LI(S5, STEPS); a.LI(A0, 0);
+    a.Label("chase");
+    a.LW(T1, T0, 4); a.ADD(A0, A0, T1); a.LW(T0, T0, 0); a.ADDI(S5, S5, -1); a.BNEZ(S5, "chase");
+    a.MV(A1, T0);
+    a.ECALL();
+    a.Finish(memoryBytes);
+}
+
+void Run_branchyProgram(std::vector<uint8_t>& memoryBytes)
+{
+    const int32_t LIMIT = 2000;
+    KernelAssembler a;
+    a.LI(S0, 1); a.LI(S1, LIMIT); a.LI(S2, 0); a.LI(S3, 0); a.LI(S4, 0); a.LI(S5, 1);
+
+    // Collatz walk for every start value, with a small branch tree on each new value
+    a.Label("start");
+    a.MV(T0, S0);
+    a.Label("walk");
+    a.BEQ(T0, S5, "walk_done");
+    a.ANDI(T1, T0, 1); a.BEQZ(T1, "even");
+    a.SLLI(T2, T0, 1); a.ADD(T0, T0, T2); a.ADDI(T0, T0, 1); a.ADDI(S3, S3, 1); a.J("classify"); // 3n + 1
+    a.Label("even");
+    a.SRLI(T0, T0, 1);
+    a.Label("classify");
+    a.ANDI(T3, T0, 7); a.BEQZ(T3, "class_zero");
+    a.SLTIU(T4, T3, 4); a.BNEZ(T4, "class_low");
+    a.ADDI(S4, S4, 5); a.J("next");
+    a.Label("class_low");
+    a.ANDI(T4, T3, 1); a.BEQZ(T4, "class_low_even");
+    a.ADDI(S4, S4, 2); a.J("next");
+    a.Label("class_low_even");
+    a.XORI(S4, S4, 0x33); a.J("next");
+    a.Label("class_zero");
+    a.ADDI(S4, S4, -1);
+    a.Label("next");
+    a.ADDI(S2, S2, 1); a.J("walk");
+    a.Label("walk_done");
+    a.ADDI(S0, S0, 1); a.BGE(S1, S0, "start");
+
+    // a0 = total steps, a1 = odd steps, a2 = branch tree state
+    a.MV(A0, S2); a.MV(A1, S3); a.MV(A2, S4);
+    a.ECALL();
+    a.Finish(memoryBytes);
+}
+
+const std::vector<GuestWorkload>& GetGuestWorkloads()
+{
+    // Golden values from a reference run; a change here means guest-visible behaviour changed
+    static const std::vector<GuestWorkload> workloads = {
+        { "memcpy",        Run_memcpyProgram,         1668007, 0x630A1F19597B4515ull, 0x24225CA41E8CF395ull },
+        { "matmul",        Run_matrixMultiplyProgram, 706796, 0x4066313256529850ull, 0x3A3AC0EFB11570FFull },
+        { "quicksort",     Run_quicksortProgram,      1185268, 0x1F4A2E51A5F9F619ull, 0xED7800267A58FC67ull },
+        { "crc32",         Run_crc32Program,          815632, 0xD26B91F88BC80BE2ull, 0x15C1F261FE3F1949ull },
+        { "dhrystone",     Run_dhrystoneProgram,      1921020, 0x9FF72162650FEDF6ull, 0x2E44E47260DE8DC1ull },
+        { "pointer_chase", Run_pointerChaseProgram,   1844077, 0x3E088217F8A55F20ull, 0xEAE48F29ABE3AFF3ull },
+        { "branchy",       Run_branchyProgram,        1819694, 0xCC87C3A7BA36B8A6ull, 0xC1A128BBB7E07EC5ull },
+    };
+    return workloads;
+}
+
+namespace {
+    uint64_t Fnv1a(uint64_t hash, const uint8_t* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+
+    const uint64_t INSTRUCTION_LIMIT = 100000000; // Far beyond any kernel; a runaway fails instead of hanging
+}
+
+uint64_t DigestRegisters(const RISCV_CPU& cpu)
+{
+    uint32_t state[32];
+    for (int i = 1; i < 32; i++) {
+        state[i - 1] = cpu.GetRegisterValue(i);
+    }
+    state[31] = cpu.GetPC();
+    return Fnv1a(FNV_OFFSET_BASIS, reinterpret_cast<const uint8_t*>(state), sizeof(state));
+}
+
+uint64_t DigestMemory(RISCV_CPU& cpu)
+{
+    cpu.LoadPendingPages();
+    const std::vector<uint8_t>& bytes = cpu.GetSharedMemory()->Bytes;
+    return Fnv1a(FNV_OFFSET_BASIS, bytes.data(), bytes.size());
+}
+
+bool RunWorkloadBenchmark(std::ostream& out, int repetitions)
+{
+    bool all_passed = true;
+
+    out << std::left << std::setw(16) << "workload" << std::right << std::setw(14) << "instructions"
+        << std::setw(10) << "MIPS" << "  result" << std::endl;
+
+    for (const GuestWorkload& workload : GetGuestWorkloads()) {
+        std::vector<uint8_t> image;
+        workload.Build(image);
+        auto cpu = std::make_unique<RISCV_CPU>();
+        cpu->LoadMemory(image, 0);
+
+        // Best of the repetitions (Reset rewinds to the loaded image in place)
+        uint64_t executed = 0;
+        double best_seconds = 0.0;
+        for (int rep = 0; rep < std::max(repetitions, 1); rep++) {
+            cpu->Reset();
+            auto start = std::chrono::steady_clock::now();
+            executed = cpu->RunFor(INSTRUCTION_LIMIT);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (rep == 0 || seconds < best_seconds) best_seconds = seconds;
+        }
+
+        bool passed = cpu->IsHalted() && executed == workload.Instructions &&
+                      DigestRegisters(*cpu) == workload.RegisterDigest && DigestMemory(*cpu) == workload.MemoryDigest;
+        all_passed = all_passed && passed;
+
+        double mips = best_seconds > 0.0 ? (double)executed / best_seconds / 1e6 : 0.0;
+        out << std::left << std::setw(16) << workload.Name << std::right << std::setw(14) << executed
+            << std::setw(10) << std::fixed << std::setprecision(1) << mips << "  " << (passed ? "ok" : "MISMATCH") << std::endl;
+    }
+    return all_passed;
+}
+
+// --- Self-tests ---
+
+namespace {
+    struct GuestState {
+        uint64_t Registers;
+        uint64_t Memory;
+        uint64_t Cycles;
+        bool operator==(const GuestState& other) const = default;
+    };
+
+    GuestState CaptureState(RISCV_CPU& cpu)
+    {
+        return { DigestRegisters(cpu), DigestMemory(cpu), cpu.GetCycleCount() };
+    }
+
+    bool ReportCheck(std::ostream& out, const char* name, bool passed)
+    {
+        out << std::left << std::setw(28) << name << (passed ? "ok" : "FAIL") << std::endl;
+        return passed;
+    }
+
+    // Stepping back lands on exactly the state the hart had there, and running forward
+    // again from it reproduces the same future (dhrystone: calls, stores, byte copies)
+    bool CheckStepBack(std::ostream& out)
+    {
+        std::vector<uint8_t> image;
+        Run_dhrystoneProgram(image);
+        auto cpu = std::make_unique<RISCV_CPU>();
+        cpu->LoadMemory(image, 0);
+        cpu->EnableUndoLog(true);
+
+        cpu->RunFor(200000);
+        GuestState before = CaptureState(*cpu);
+        cpu->RunFor(50000);
+        GuestState after = CaptureState(*cpu);
+
+        bool passed = cpu->StepBack(50000) == 50000 && CaptureState(*cpu) == before;
+        cpu->RunFor(50000);
+        passed = passed && CaptureState(*cpu) == after;
+
+        // Back to a PC seen earlier, and no further than the start of the run
+        uint32_t pc = cpu->GetPC();
+        cpu->RunFor(1000);
+        passed = passed && cpu->RunBackwardUntil(pc) && cpu->GetPC() == pc;
+        uint64_t depth = cpu->GetUndoDepth();
+        passed = passed && cpu->StepBack(INSTRUCTION_LIMIT) == depth && cpu->GetUndoDepth() == 0;
+        return ReportCheck(out, "undo: step back", passed);
+    }
+
+    // Events fire at their cycle during RunFor, the clock stays in step with the core
+    // between runs, and Reset drops what is still pending
+    bool CheckScheduler(std::ostream& out)
+    {
+        std::vector<uint8_t> image;
+        Run_branchyProgram(image);
+        RISCV_EventScheduler scheduler;
+        auto cpu = std::make_unique<RISCV_CPU>();
+        cpu->LoadMemory(image, 0);
+        cpu->AttachScheduler(&scheduler);
+
+        uint64_t fired_at = 0;
+        scheduler.ScheduleAt(10000, [&](uint64_t cycle) { fired_at = cycle; });
+        cpu->RunFor(20000);
+        bool passed = fired_at == 10000 && scheduler.GetNow() == cpu->GetCycleCount();
+
+        uint64_t due = cpu->GetCycleCount() + 500;
+        scheduler.ScheduleIn(500, [&](uint64_t cycle) { fired_at = cycle; });
+        cpu->RunFor(1000);
+        passed = passed && fired_at == due && scheduler.GetNow() == cpu->GetCycleCount();
+
+        scheduler.ScheduleIn(500, [&](uint64_t cycle) { fired_at = cycle; });
+        cpu->Reset();
+        passed = passed && scheduler.GetPendingCount() == 0 && scheduler.GetNow() == 0;
+        return ReportCheck(out, "scheduler: clock sync", passed);
+    }
+
+    // A checkpoint saved halfway through a kernel resumes (lazily) to its golden result,
+    // and a damaged page still loads but faults when the hart touches it
+    bool CheckCheckpointFile(std::ostream& out)
+    {
+        const GuestWorkload& workload = GetGuestWorkloads()[2]; // quicksort: deep stack, data all over RAM
+        std::vector<uint8_t> image;
+        workload.Build(image);
+        std::string path = (std::filesystem::temp_directory_path() / "riscv_selftest.rvck").string();
+
+        auto cpu = std::make_unique<RISCV_CPU>();
+        cpu->LoadMemory(image, 0);
+        uint64_t first = cpu->RunFor(workload.Instructions / 2);
+        bool passed = RISCV_CheckpointFile::Save(*cpu, path);
+
+        auto resumed = std::make_unique<RISCV_CPU>();
+        passed = passed && RISCV_CheckpointFile::Load(*resumed, path) && resumed->GetPendingPageCount() > 0;
+        uint64_t second = resumed->RunFor(INSTRUCTION_LIMIT);
+        passed = passed && resumed->IsHalted() && first + second == workload.Instructions &&
+                 DigestRegisters(*resumed) == workload.RegisterDigest && DigestMemory(*resumed) == workload.MemoryDigest;
+
+        // The last byte of the file belongs to the last page record, the top of the stack
+        std::vector<char> bytes;
+        {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        if (!bytes.empty()) bytes.back() ^= 0x5A;
+        {
+            std::ofstream damaged(path, std::ios::binary | std::ios::trunc);
+            damaged.write(bytes.data(), (std::streamsize)bytes.size());
+        }
+        auto corrupt = std::make_unique<RISCV_CPU>();
+        passed = passed && RISCV_CheckpointFile::Load(*corrupt, path);
+        uint32_t stack_page = (uint32_t)(STACK_TOP - 4) & ~(RISCV_CPU::PAGE_SIZE - 1);
+        corrupt->SetPC(stack_page);
+        corrupt->RunFor(1);
+        ArchCheckpoint state = corrupt->SaveCheckpoint();
+        passed = passed && state.MCause == 1 && state.MTval == stack_page && // Instruction access fault
+                 !corrupt->LoadPendingPages() && corrupt->GetPendingPageCount() == 1;
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return ReportCheck(out, "checkpoint file: round trip", passed);
+    }
+
+    // A breakpoint stops before its instruction and is stepped over on the next run;
+    // a write watchpoint reports the store, and a read watchpoint ignores it
+    bool CheckDebugStops(std::ostream& out)
+    {
+        const int32_t COUNTER = 0x8000;
+        KernelAssembler a;
+        a.LI(S0, COUNTER); a.LI(T0, 0); a.LI(T1, 10);
+        a.Label("loop");
+        a.ADDI(T0, T0, 1);
+        a.Label("store");
+        a.SW(T0, S0, 0);
+        a.BNE(T0, T1, "loop");
+        a.ECALL();
+        std::vector<uint8_t> image;
+        a.Finish(image);
+
+        auto cpu = std::make_unique<RISCV_CPU>();
+        cpu->LoadMemory(image, 0);
+        cpu->AddBreakpoint(a.Address("loop"));
+        cpu->RunFor(1000);
+        const StopInfo& stop = cpu->GetStopInfo();
+        bool passed = stop.Reason == StopReason::Breakpoint && cpu->GetPC() == a.Address("loop") && cpu->GetRegisterValue(T0) == 0;
+        cpu->RunFor(1000);
+        passed = passed && stop.Reason == StopReason::Breakpoint && cpu->GetRegisterValue(T0) == 1;
+
+        cpu->ClearBreakpoints();
+        cpu->AddWatchpoint(COUNTER, 4, WatchType::Write);
+        cpu->RunFor(1000);
+        passed = passed && stop.Reason == StopReason::Watchpoint && stop.PC == a.Address("store") &&
+                 stop.Addr == COUNTER && stop.Size == 4 && stop.Value == 2 && stop.bWrite;
+
+        cpu->ClearBreakpoints();
+        cpu->AddWatchpoint(COUNTER, 4, WatchType::Read);
+        cpu->RunFor(1000);
+        passed = passed && stop.Reason == StopReason::Halted && cpu->GetRegisterValue(T0) == 10;
+        return ReportCheck(out, "debug: breakpoints", passed);
+    }
+}
+
+bool RunSelfTests(std::ostream& out)
+{
+    bool all_passed = CheckStepBack(out);
+    all_passed = CheckScheduler(out) && all_passed;
+    all_passed = CheckCheckpointFile(out) && all_passed;
+    all_passed = CheckDebugStops(out) && all_passed;
+    return all_passed;
+}
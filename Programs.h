@@ -1,4 +1,44 @@
 #pragma once
+#include <cstdint>
+#include <iostream>
 #include <vector>
 
+class RISCV_CPU;
+
 void Run_fibonacciProgram(std::vector<uint8_t>& memoryBytes);
+
+// --- Workload corpus ---
+// Terminating kernels for throughput regression runs. Like Run_fibonacciProgram,
+// each appends an image to be loaded at address 0. They build their own data,
+// leave a checksum in a0 and end with ECALL (the hart halts, see RISCV_CPU::IsHalted).
+void Run_memcpyProgram(std::vector<uint8_t>& memoryBytes);         // memset, word and byte memcpy
+void Run_matrixMultiplyProgram(std::vector<uint8_t>& memoryBytes); // 24x24 integer matmul (shift-add multiply, no M extension)
+void Run_quicksortProgram(std::vector<uint8_t>& memoryBytes);      // Recursive quicksort of 8192 words
+void Run_crc32Program(std::vector<uint8_t>& memoryBytes);          // Table-driven CRC32 over 64 KiB
+void Run_dhrystoneProgram(std::vector<uint8_t>& memoryBytes);      // Dhrystone-like mix of calls, strings and records
+void Run_pointerChaseProgram(std::vector<uint8_t>& memoryBytes);   // Dependent loads around a 256 KiB linked ring
+void Run_branchyProgram(std::vector<uint8_t>& memoryBytes);        // Collatz walks: data-dependent branches
+
+struct GuestWorkload {
+    const char* Name;
+    void (*Build)(std::vector<uint8_t>& memoryBytes);
+    // Golden results at the final ECALL
+    uint64_t Instructions;
+    uint64_t RegisterDigest; // DigestRegisters()
+    uint64_t MemoryDigest;   // DigestMemory()
+};
+const std::vector<GuestWorkload>& GetGuestWorkloads();
+
+// FNV-1a digests of the architectural state: x1-x31 and PC, and all of guest RAM
+uint64_t DigestRegisters(const RISCV_CPU& cpu);
+uint64_t DigestMemory(RISCV_CPU& cpu);
+
+// Runs every workload to completion (best of 'repetitions' runs), printing guest MIPS
+// per kernel and whether the final state matches its golden digests.
+// Returns true if every workload matched.
+bool RunWorkloadBenchmark(std::ostream& out, int repetitions = 3);
+
+// Focused checks of the simulator's own machinery against the kernels above: undo and
+// StepBack, event scheduler timing, checkpoint files (round trip and a damaged page),
+// and breakpoints/watchpoints. Prints one line per check; returns true if all passed.
+bool RunSelfTests(std::ostream& out);
@@ -0,0 +1,128 @@
+#include "RISCV_BBVProfiler.h"
+#include <algorithm>
+
+RISCV_BBVProfiler::RISCV_BBVProfiler(uint64_t intervalSize) {
+    IntervalSize = std::max<uint64_t>(intervalSize, 1);
+    Reset();
+}
+
+void RISCV_BBVProfiler::Reset() {
+    BlockIds.clear();
+    IntervalCounts.assign(1, 0); // Id 0 is unused
+    TouchedBlocks.clear();
+    Checkpoints.clear();
+
+    BlockLength = 0;
+    BlockStartPC = 0;
+    bBlockOpen = false;
+    InIntervalCount = 0;
+    Intervals = 0;
+    TotalInstructions = 0;
+}
+
+void RISCV_BBVProfiler::SetCheckpointIntervals(const std::vector<uint64_t>& intervals) {
+    CheckpointIntervals = intervals;
+    std::sort(CheckpointIntervals.begin(), CheckpointIntervals.end());
+}
+
+uint32_t RISCV_BBVProfiler::GetBlockId(uint32_t startPC) {
+    auto found = BlockIds.find(startPC);
+    if (found != BlockIds.end()) return found->second;
+
+    uint32_t id = (uint32_t)IntervalCounts.size();
+    BlockIds.emplace(startPC, id);
+    IntervalCounts.push_back(0);
+    return id;
+}
+
+void RISCV_BBVProfiler::CountBlock() {
+    if (BlockLength == 0) return;
+
+    uint32_t id = GetBlockId(BlockStartPC);
+    if (IntervalCounts[id] == 0) {
+        TouchedBlocks.push_back(id);
+    }
+    IntervalCounts[id] += BlockLength;
+    BlockLength = 0;
+}
+
+void RISCV_BBVProfiler::EndBlock() {
+    CountBlock();
+    bBlockOpen = false;
+}
+
+void RISCV_BBVProfiler::EmitInterval(std::ostream& bbvOut) {
+    bbvOut << "T";
+    for (uint32_t id : TouchedBlocks) {
+        bbvOut << ":" << id << ":" << IntervalCounts[id] << " ";
+        IntervalCounts[id] = 0;
+    }
+    bbvOut << "\n";
+
+    TouchedBlocks.clear();
+    InIntervalCount = 0;
+    Intervals++;
+}
+
+uint64_t RISCV_BBVProfiler::Run(RISCV_CPU& cpu, uint64_t maxInstructions, std::ostream& bbvOut) {
+    size_t next_checkpoint = 0;
+    while (next_checkpoint < CheckpointIntervals.size() && CheckpointIntervals[next_checkpoint] < Intervals) {
+        next_checkpoint++;
+    }
+
+    uint64_t n = 0;
+    for (; n < maxInstructions; n++) {
+        if (cpu.IsHalted()) break; // ECALL/EBREAK with no handler ended the program
+
+        // Interval boundary: checkpoint here if this interval was chosen
+        if (InIntervalCount == 0 && next_checkpoint < CheckpointIntervals.size() && CheckpointIntervals[next_checkpoint] == Intervals) {
+            Checkpoints.push_back({ Intervals, TotalInstructions, cpu.SaveCheckpoint() });
+            next_checkpoint++;
+        }
+
+        uint32_t pc = cpu.GetPC();
+        if (!bBlockOpen) {
+            BlockStartPC = pc;
+            bBlockOpen = true;
+        }
+
+        DecodedInstruction decoded = cpu.Decode(cpu.FetchInstruction());
+        cpu.Execute(decoded);
+        BlockLength++;
+        InIntervalCount++;
+        TotalInstructions++;
+
+        // A block ends at any control transfer, taken or not
+        OpcodeType op = static_cast<OpcodeType>(decoded.opcode);
+        bool is_control = (op == OpcodeType::BRANCH || op == OpcodeType::JAL || op == OpcodeType::JALR);
+        if (is_control || cpu.GetPC() != pc + 4) {
+            EndBlock();
+        }
+
+        // Interval boundary: a block cut in half is counted in both intervals, each
+        // part under the block's own entry PC (the block stays open across the boundary)
+        if (InIntervalCount == IntervalSize) {
+            CountBlock();
+            EmitInterval(bbvOut);
+        }
+    }
+
+    // The program is done, so its last (short) interval will not fill up any more
+    if (cpu.IsHalted() && InIntervalCount > 0) {
+        EndBlock();
+        EmitInterval(bbvOut);
+    }
+    return n;
+}
+
+const std::vector<RISCV_BBVProfiler::IntervalCheckpoint>& RISCV_BBVProfiler::GetCheckpoints() const {
+    return Checkpoints;
+}
+
+uint64_t RISCV_BBVProfiler::GetIntervalCount() const {
+    return Intervals;
+}
+
+size_t RISCV_BBVProfiler::GetBlockCount() const {
+    return BlockIds.size();
+}
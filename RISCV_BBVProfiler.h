@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "RISCV_CPU.h"
+
+/**
+ * Basic-block vector profiler for SimPoint-style sampling.
+ *
+ * Execution is cut into fixed-size instruction intervals. For every interval
+ * it writes one line in SimPoint's .bb format:
+ *
+ *     T:<block id>:<count> :<block id>:<count> ...
+ *
+ * where count is the number of instructions executed in that block (entries
+ * weighted by block length). Feed the file to SimPoint to pick representative
+ * intervals, then run again with those intervals as checkpoint points: the
+ * profiler captures an ArchCheckpoint at the start of each one, and a detailed
+ * model can start straight from RISCV_CPU::RestoreCheckpoint().
+ */
+class RISCV_BBVProfiler {
+public:
+    explicit RISCV_BBVProfiler(uint64_t intervalSize = DEFAULT_INTERVAL);
+
+    // Interval indices (0 = the first interval) whose start should be checkpointed
+    void SetCheckpointIntervals(const std::vector<uint64_t>& intervals);
+
+    // Runs the CPU functionally, writing one BBV line per completed interval. Stops
+    // early if the program halts, writing what there is of the last interval too.
+    // Returns the number of instructions run.
+    uint64_t Run(RISCV_CPU& cpu, uint64_t maxInstructions, std::ostream& bbvOut);
+
+    struct IntervalCheckpoint {
+        uint64_t Interval;
+        uint64_t InstructionCount; // Instructions executed before the checkpoint
+        ArchCheckpoint State;
+    };
+    const std::vector<IntervalCheckpoint>& GetCheckpoints() const;
+
+    uint64_t GetIntervalCount() const;
+    size_t GetBlockCount() const;
+    void Reset();
+
+    static const uint64_t DEFAULT_INTERVAL = 10000000; // SimPoint's usual 10M instructions
+
+private:
+    uint32_t GetBlockId(uint32_t startPC);
+    void CountBlock(); // Credits the instructions run so far to the current block
+    void EndBlock();
+    void EmitInterval(std::ostream& bbvOut);
+
+    uint64_t IntervalSize;
+    std::vector<uint64_t> CheckpointIntervals; // Sorted
+    std::vector<IntervalCheckpoint> Checkpoints;
+
+    // Block ids are 1-based, as SimPoint expects
+    std::unordered_map<uint32_t, uint32_t> BlockIds;
+
+    // Counts for the current interval (indexed by block id), plus the ids touched so far
+    std::vector<uint64_t> IntervalCounts;
+    std::vector<uint32_t> TouchedBlocks;
+
+    uint32_t BlockStartPC;
+    uint32_t BlockLength; // Instructions not yet credited to the block
+    bool bBlockOpen;
+    uint64_t InIntervalCount;
+    uint64_t Intervals;
+    uint64_t TotalInstructions;
+};
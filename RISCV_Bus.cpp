@@ -0,0 +1,228 @@
+#include "RISCV_Bus.h"
+#include <algorithm>
+
+/*
+    UART
+*/
+
+RISCV_UART::RISCV_UART() {
+    InPos = 0;
+    OutBuffer.reserve(FLUSH_THRESHOLD);
+    OutputSink = [](const char* data, size_t len) {
+        std::cout.write(data, len);
+        std::cout.flush();
+    };
+}
+
+RISCV_UART::~RISCV_UART() {
+    Flush();
+}
+
+uint32_t RISCV_UART::Read(uint32_t offset, int size, uint64_t now) {
+    std::lock_guard<std::mutex> lock(Lock);
+    switch (offset) {
+        case REG_DATA:
+            if (InPos < InBuffer.size()) {
+                return (uint8_t)InBuffer[InPos++];
+            }
+            return 0;
+
+        case REG_LSR:
+            // We can always accept another character
+            return LSR_THR_EMPTY | (InPos < InBuffer.size() ? LSR_DATA_READY : 0);
+
+        default:
+            return 0;
+    }
+}
+
+void RISCV_UART::Write(uint32_t offset, uint32_t data, int size, uint64_t now) {
+    if (offset != REG_DATA) return; // Line control registers are ignored
+
+    std::lock_guard<std::mutex> lock(Lock);
+    OutBuffer.push_back((char)(data & 0xFF));
+    if (OutBuffer.size() >= FLUSH_THRESHOLD) {
+        FlushLocked();
+    }
+}
+
+void RISCV_UART::Reset() {
+    std::lock_guard<std::mutex> lock(Lock);
+    FlushLocked();
+    InBuffer.clear();
+    InPos = 0;
+}
+
+void RISCV_UART::Flush() {
+    std::lock_guard<std::mutex> lock(Lock);
+    FlushLocked();
+}
+
+void RISCV_UART::FlushLocked() {
+    if (OutBuffer.empty()) return;
+
+    if (OutputSink) {
+        OutputSink(OutBuffer.data(), OutBuffer.size());
+    }
+    OutBuffer.clear();
+}
+
+void RISCV_UART::SetOutputSink(std::function<void(const char*, size_t)> sink) {
+    std::lock_guard<std::mutex> lock(Lock);
+    FlushLocked();
+    OutputSink = sink;
+}
+
+void RISCV_UART::PushInput(const std::string& text) {
+    std::lock_guard<std::mutex> lock(Lock);
+
+    // Drop what the guest already consumed before appending
+    InBuffer.erase(0, InPos);
+    InPos = 0;
+    InBuffer += text;
+}
+
+/*
+    CLINT
+*/
+
+RISCV_CLINT::RISCV_CLINT(uint32_t numHarts) {
+    numHarts = std::max(numHarts, 1u);
+    MSIP.resize(numHarts);
+    MTimeCmp.resize(numHarts);
+    Reset();
+}
+
+void RISCV_CLINT::Reset() {
+    std::lock_guard<std::mutex> lock(Lock);
+    std::fill(MSIP.begin(), MSIP.end(), 0);
+    std::fill(MTimeCmp.begin(), MTimeCmp.end(), UINT64_MAX); // Disarmed
+    TimeOffset = 0;
+}
+
+uint64_t RISCV_CLINT::GetTime(uint64_t now) const {
+    std::lock_guard<std::mutex> lock(Lock);
+    return now + (uint64_t)TimeOffset;
+}
+
+uint64_t RISCV_CLINT::GetTimeCompare(uint32_t hart) const {
+    std::lock_guard<std::mutex> lock(Lock);
+    return hart < MTimeCmp.size() ? MTimeCmp[hart] : UINT64_MAX;
+}
+
+bool RISCV_CLINT::IsTimerPending(uint64_t now, uint32_t hart) const {
+    return GetTime(now) >= GetTimeCompare(hart);
+}
+
+bool RISCV_CLINT::IsSoftwarePending(uint32_t hart) const {
+    std::lock_guard<std::mutex> lock(Lock);
+    return hart < MSIP.size() && MSIP[hart] != 0;
+}
+
+uint32_t RISCV_CLINT::GetNumHarts() const {
+    return (uint32_t)MSIP.size();
+}
+
+uint64_t RISCV_CLINT::GetTimerDeadline(uint32_t hart) const {
+    std::lock_guard<std::mutex> lock(Lock);
+    if (hart >= MTimeCmp.size() || MTimeCmp[hart] == UINT64_MAX) return UINT64_MAX;
+    return MTimeCmp[hart] - (uint64_t)TimeOffset;
+}
+
+uint32_t RISCV_CLINT::Read(uint32_t offset, int size, uint64_t now) {
+    std::lock_guard<std::mutex> lock(Lock);
+    if (offset & 0x3) return 0;
+
+    if (offset >= REG_MTIME) {
+        uint64_t time = now + (uint64_t)TimeOffset;
+        if (offset == REG_MTIME) return (uint32_t)time;
+        if (offset == REG_MTIME + 4) return (uint32_t)(time >> 32);
+        return 0;
+    }
+    if (offset >= REG_MTIMECMP) {
+        uint32_t hart = (offset - REG_MTIMECMP) / 8;
+        if (hart >= MTimeCmp.size()) return 0;
+        return (offset & 0x4) ? (uint32_t)(MTimeCmp[hart] >> 32) : (uint32_t)MTimeCmp[hart];
+    }
+    uint32_t hart = (offset - REG_MSIP) / 4;
+    return hart < MSIP.size() ? MSIP[hart] : 0;
+}
+
+void RISCV_CLINT::Write(uint32_t offset, uint32_t data, int size, uint64_t now) {
+    std::lock_guard<std::mutex> lock(Lock);
+    if (offset & 0x3) return;
+
+    if (offset >= REG_MTIME) {
+        uint64_t time = now + (uint64_t)TimeOffset;
+        if (offset == REG_MTIME) {
+            time = (time & 0xFFFFFFFF00000000ull) | data;
+        } else if (offset == REG_MTIME + 4) {
+            time = (time & 0x00000000FFFFFFFFull) | ((uint64_t)data << 32);
+        } else {
+            return;
+        }
+        TimeOffset = (int64_t)(time - now);
+    } else if (offset >= REG_MTIMECMP) {
+        uint32_t hart = (offset - REG_MTIMECMP) / 8;
+        if (hart >= MTimeCmp.size()) return;
+        if (offset & 0x4) {
+            MTimeCmp[hart] = (MTimeCmp[hart] & 0x00000000FFFFFFFFull) | ((uint64_t)data << 32);
+        } else {
+            MTimeCmp[hart] = (MTimeCmp[hart] & 0xFFFFFFFF00000000ull) | data;
+        }
+    } else {
+        uint32_t hart = (offset - REG_MSIP) / 4;
+        if (hart < MSIP.size()) MSIP[hart] = data & 1;
+    }
+}
+
+/*
+    Bus
+*/
+
+RISCV_Bus::RISCV_Bus() {
+    LastHit = 0;
+}
+
+void RISCV_Bus::Map(uint32_t base, uint32_t size, std::shared_ptr<RISCV_Device> device) {
+    Regions.push_back({ base, size, device });
+}
+
+const RISCV_Bus::Region* RISCV_Bus::FindRegion(uint32_t addr, int size) {
+    // Unsigned subtraction makes "addr below base" wrap around and fail the check
+    if (LastHit < Regions.size()) {
+        const Region& r = Regions[LastHit];
+        if (addr - r.Base < r.Size && addr - r.Base + size <= r.Size) return &r;
+    }
+
+    for (size_t i = 0; i < Regions.size(); i++) {
+        const Region& r = Regions[i];
+        if (addr - r.Base < r.Size && addr - r.Base + size <= r.Size) {
+            LastHit = i;
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+bool RISCV_Bus::Read(uint32_t addr, int size, uint64_t now, uint32_t& value) {
+    const Region* r = FindRegion(addr, size);
+    if (!r) return false;
+
+    value = r->Device->Read(addr - r->Base, size, now);
+    return true;
+}
+
+bool RISCV_Bus::Write(uint32_t addr, uint32_t data, int size, uint64_t now) {
+    const Region* r = FindRegion(addr, size);
+    if (!r) return false;
+
+    r->Device->Write(addr - r->Base, data, size, now);
+    return true;
+}
+
+void RISCV_Bus::ResetDevices() {
+    for (Region& r : Regions) {
+        r.Device->Reset();
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// --- Default Memory Map (same addresses as the QEMU "virt" board) ---
+// Everything below RISCV_CPU::MEMORY_SIZE is RAM. Devices live above it.
+static const uint32_t CLINT_BASE = 0x02000000;
+static const uint32_t CLINT_SIZE = 0x00010000;
+static const uint32_t UART_BASE  = 0x10000000;
+static const uint32_t UART_SIZE  = 0x00000100;
+
+/**
+ * Base class for anything mapped on the device bus.
+ * Offsets are relative to the start of the region the device is mapped at.
+ * 'now' is the CPU cycle count at the time of the access, so devices that
+ * keep time (like the CLINT) never need to be ticked.
+ */
+class RISCV_Device {
+public:
+    virtual ~RISCV_Device() {}
+
+    virtual uint32_t Read(uint32_t offset, int size, uint64_t now) = 0;
+    virtual void Write(uint32_t offset, uint32_t data, int size, uint64_t now) = 0;
+
+    // Put the device back into its power-on state
+    virtual void Reset() {}
+};
+
+/**
+ * Console UART with a 16550-style register layout.
+ * Transmitted characters are collected in a buffer and handed to the output
+ * sink in bulk (when the buffer fills up or Flush() is called), instead of
+ * going through std::cout once per character. Harts of a RISCV_HartGroup share
+ * one UART from several threads, so every access takes a lock.
+ */
+class RISCV_UART : public RISCV_Device {
+public:
+    RISCV_UART();
+    ~RISCV_UART();
+
+    uint32_t Read(uint32_t offset, int size, uint64_t now) override;
+    void Write(uint32_t offset, uint32_t data, int size, uint64_t now) override;
+    void Reset() override;
+
+    // Hand everything buffered so far to the output sink
+    void Flush();
+
+    // Replace the default sink (std::cout) - e.g. to forward output to a log
+    void SetOutputSink(std::function<void(const char*, size_t)> sink);
+
+    // Queue characters for the guest to read from the receive register
+    void PushInput(const std::string& text);
+
+    // Registers (byte offsets)
+    static const uint32_t REG_DATA = 0x0; // THR on write, RBR on read
+    static const uint32_t REG_LSR  = 0x5; // Line Status Register
+
+    // Line Status bits
+    static const uint32_t LSR_DATA_READY = 0x01;
+    static const uint32_t LSR_THR_EMPTY  = 0x20;
+
+    // Buffered characters before an automatic flush
+    static const size_t FLUSH_THRESHOLD = 4096;
+
+private:
+    void FlushLocked();
+
+    std::mutex Lock;
+    std::string OutBuffer;
+    std::string InBuffer;
+    size_t InPos;
+    std::function<void(const char*, size_t)> OutputSink;
+};
+
+/**
+ * Core Local Interruptor: the standard RISC-V machine timer, plus one msip and
+ * one mtimecmp per hart. mtime is derived from the cycle count of the accessing
+ * hart on demand, so there is nothing to update per instruction. A hart group
+ * shares one CLINT; its harts' cycle counts stay within a quantum of each other.
+ */
+class RISCV_CLINT : public RISCV_Device {
+public:
+    explicit RISCV_CLINT(uint32_t numHarts = 1);
+
+    uint32_t Read(uint32_t offset, int size, uint64_t now) override;
+    void Write(uint32_t offset, uint32_t data, int size, uint64_t now) override;
+    void Reset() override;
+
+    uint64_t GetTime(uint64_t now) const;
+    uint64_t GetTimeCompare(uint32_t hart = 0) const;
+    bool IsTimerPending(uint64_t now, uint32_t hart = 0) const;
+    bool IsSoftwarePending(uint32_t hart = 0) const;
+    uint32_t GetNumHarts() const;
+
+    // The cycle at which mtime reaches the hart's mtimecmp (UINT64_MAX if never armed)
+    uint64_t GetTimerDeadline(uint32_t hart = 0) const;
+
+    // Registers (byte offsets, 64-bit registers are accessed as two words)
+    static const uint32_t REG_MSIP     = 0x0000; // + 4 * hart
+    static const uint32_t REG_MTIMECMP = 0x4000; // + 8 * hart
+    static const uint32_t REG_MTIME    = 0xBFF8;
+
+private:
+    mutable std::mutex Lock; // Harts on other threads may access it at the same time
+    std::vector<uint32_t> MSIP;
+    std::vector<uint64_t> MTimeCmp;
+    int64_t TimeOffset; // mtime = now + TimeOffset (changes when the guest writes mtime)
+};
+
+/**
+ * Address-range device bus.
+ * The CPU only consults it for addresses outside RAM, so the region table is
+ * never on the path of an ordinary load or store.
+ */
+class RISCV_Bus {
+public:
+    RISCV_Bus();
+
+    void Map(uint32_t base, uint32_t size, std::shared_ptr<RISCV_Device> device);
+
+    // Return false if no device claims the address
+    bool Read(uint32_t addr, int size, uint64_t now, uint32_t& value);
+    bool Write(uint32_t addr, uint32_t data, int size, uint64_t now);
+
+    void ResetDevices();
+
+private:
+    struct Region {
+        uint32_t Base;
+        uint32_t Size;
+        std::shared_ptr<RISCV_Device> Device;
+    };
+
+    const Region* FindRegion(uint32_t addr, int size);
+
+    std::vector<Region> Regions;
+    size_t LastHit; // Guests usually hammer one device at a time
+};
@@ -1,21 +1,67 @@
 #include "RISCV_CPU.h"
+#include "RISCV_Disassembler.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
 #include <iomanip> // Used for std::hex formatting
 
-RISCV_CPU::RISCV_CPU() {
-    
-    // Resize Memory - fill with zeros
-    Memory.resize(MEMORY_SIZE, 0);
+RISCV_CPU::RISCV_CPU() : RISCV_CPU(std::make_shared<GuestMemory>(MEMORY_SIZE, NUM_PAGES), 0) {
+}
+
+RISCV_CPU::RISCV_CPU(std::shared_ptr<GuestMemory> sharedMemory, uint32_t hartId,
+                     std::shared_ptr<RISCV_UART> uart, std::shared_ptr<RISCV_CLINT> clint) {
+
+    // Memory - zero-filled by GuestMemory, possibly shared with other harts
+    Mem = sharedMemory;
+    Memory = Mem->Bytes.data();
+    DirtyPageFlags = Mem->DirtyPageFlags.data();
+    HartId = hartId;
+    bReservationValid = false;
+    ReservationAddr = 0;
+    ReservationValue = 0;
+    ReservationStamp = 0;
+
     // Initialize Program Counter to 0 (or entry point)
     PC = 0;
+    CycleCount = 0;
+    StallCycle = 0;
+    Scheduler = nullptr;
+    TraceSink = nullptr;
+    Predecoded = nullptr;
+    PredecodedBase = 0;
+    PredecodedCount = 0;
+    std::fill(PendingPageFlags, PendingPageFlags + NUM_PAGES, 0);
+    PendingPageCount = 0;
+    bUndoEnabled = false;
+    bUndoStores = false;
+    bIdleSkipEnabled = true;
+    WriteCount = 0;
+    SkippedCycles = 0;
+    ResetIdleDetection();
+    Stop = StopInfo{};
+    bStopRequested = false;
+    bHalted = false;
+    RebuildWatchFlags();
+    ResetVectorUnit();
+    ResetFloatUnit();
+    ResetPrivilegedState();
 
     // Initialize all registers to 0
     for (int i = 0; i < 32; i++) {
         Registers[i] = 0;
     }
+    Registers[10] = HartId; // a0 = hart id, as boot firmware passes it
+
+    // Attach the default devices (shared with the other harts when given)
+    Uart = uart ? uart : std::make_shared<RISCV_UART>();
+    Clint = clint ? clint : std::make_shared<RISCV_CLINT>(HartId + 1);
+    Bus.Map(UART_BASE, UART_SIZE, Uart);
+    Bus.Map(CLINT_BASE, CLINT_SIZE, Clint);
 }
 
 RISCV_CPU::~RISCV_CPU() {
-    // Cleanup if necessary
+    ClearReservation(); // Other harts would otherwise keep stamping stores for it
 }
 
 DecodedInstruction RISCV_CPU::Decode(uint32_t inst) {
@@ -28,6 +74,7 @@ DecodedInstruction RISCV_CPU::Decode(uint32_t inst) {
     decoded.rs1 = (inst >> RS1_SHIFT) & REG_MASK;
     decoded.rs2 = (inst >> RS2_SHIFT) & REG_MASK;
     decoded.funct7 = (inst >> FUNCT7_SHIFT) & FUNCT7_MASK;
+    decoded.raw = inst;
 
     // Generate the Immediate Value
     decoded.imm = GenerateImmediate(inst, decoded.opcode);
@@ -60,13 +107,15 @@ int32_t RISCV_CPU::GenerateImmediate(uint32_t inst, uint32_t opcode) {
         case OpcodeType::LOAD:
         case OpcodeType::OP_IMM:
         case OpcodeType::SYSTEM:
+        case OpcodeType::LOAD_FP:
             // Cast to signed int so '>> 20' performs arithmetic shift (preserves sign)
             imm = (int32_t)inst >> 20; 
             break;
 
         // --- S-Type (Immediate is split into two parts) ---
         // Instructions: SW, SH, SB
-        case OpcodeType::STORE: {
+        case OpcodeType::STORE:
+        case OpcodeType::STORE_FP: {
             int32_t low = (inst >> 7) & 0x1F;   // Bottom 5 bits
             int32_t high = (inst >> 25) & 0x7F; // Top 7 bits
             imm = (high << 5) | low;            // Combine them
@@ -129,7 +178,14 @@ int32_t RISCV_CPU::GenerateImmediate(uint32_t inst, uint32_t opcode) {
 
 
 void RISCV_CPU::Execute(DecodedInstruction& inst) {
-    
+
+    // Reverse execution: remember what this instruction is about to overwrite
+    UndoRecord* undo = nullptr;
+    if (bUndoEnabled) {
+        if (UndoLog.NeedsNewChunk()) SaveUndoCheckpoint(); // Every chunk starts at a checkpoint
+        undo = &UndoLog.Push(PC);
+    }
+
     //OPERAND PREPARATION (The "MUX" Logic)   
     // Source 1 (rs1) is always used if the instruction needs it.
     int32_t val1 = (int32_t)Registers[inst.rs1];
@@ -221,7 +277,7 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
                 case 0x5: take_branch = (val1 >= val2); break; // BGE
                 case 0x6: take_branch = ((uint32_t)val1 < (uint32_t)val2); break;  // BLTU
                 case 0x7: take_branch = ((uint32_t)val1 >= (uint32_t)val2); break; // BGEU
-                default:  break;
+                default:  RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw); break;
             }
 
             if (take_branch) {
@@ -241,6 +297,11 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
             next_pc = (val1 + inst.imm) & ~1;
             break;
 
+        // --- ATOMICS (RV32A) ---
+        case OpcodeType::AMO:
+            result = (int32_t)ExecuteAtomic(inst, (uint32_t)val1, Registers[inst.rs2], undo);
+            break;
+
         // --- UPPER IMMEDIATES (U-Type) ---
         case OpcodeType::LUI:
             result = inst.imm; // Load Upper Immediate directly
@@ -272,6 +333,7 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
                     result = MemRead(addr, 2, false);
                     break;
                 default:
+                    RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
                     break;
             }
             break;
@@ -280,6 +342,10 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
         case OpcodeType::STORE: {
             write_to_reg = false; // Stores do NOT write to rd
             uint32_t addr = val1 + inst.imm; // Effective Address
+
+            if (undo && inst.funct3 <= 0x2) {
+                RecordStoreUndo(*undo, addr, 1 << inst.funct3); // SB/SH/SW write 1/2/4 bytes
+            }
             
             // For Store, val2 holds the data we want to write (from rs2)
             switch (inst.funct3) {
@@ -293,26 +359,123 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
                     MemWrite(addr, val2, 4);
                     break;
                 default:
+                    RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
                     break;
             }
+            bUndoStores = false;
             break;
         }
 
-        case OpcodeType::SYSTEM:
+        case OpcodeType::SYSTEM: {
+            if (inst.funct3 == 0x0) {
+                write_to_reg = false;
+                if (inst.raw == 0x30200073) { // MRET
+                    if (undo) RecordControlUndo();
+                    if (Privilege != PRIV_M) {
+                        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+                        break;
+                    }
+                    ReturnFromTrap();
+                    next_pc = PC; // ReturnFromTrap() set it to mepc
+                } else if ((inst.raw & 0xFE007FFF) == 0x12000073) { // SFENCE.VMA
+                    if (Privilege == PRIV_U) {
+                        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+                    } else if (inst.rs1 == 0) {
+                        FlushTLB();
+                    } else {
+                        FlushTLBAddress(Registers[inst.rs1]);
+                    }
+                } else if (inst.raw == 0x00000073 || inst.raw == 0x00100073) { // ECALL / EBREAK
+                    if (MTvec == 0) { // No handler: the program is done
+                        bHalted = true;
+                        bStopRequested = true;
+                        Stop.Reason = StopReason::Halted;
+                        Stop.PC = PC;
+                        next_pc = PC;
+                    } else if (inst.raw == 0x00000073) {
+                        RaiseTrap(CAUSE_ECALL_FROM_U + Privilege, 0);
+                    } else {
+                        RaiseTrap(CAUSE_BREAKPOINT, PC);
+                    }
+                } else if (inst.raw != 0x10500073) { // WFI is a legal no-op (nothing to wait for)
+                    RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+                }
+                break;
+            }
+            if (inst.funct3 == 0x4) { // Reserved
+                RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+                break;
+            }
+
+            // Zicsr: CSRRW(I) always writes, CSRRS(I)/CSRRC(I) only with a non-zero rs1/uimm
+            bool csr_write = (inst.funct3 & 0x3) == 0x1 || inst.rs1 != 0;
+            if (csr_write && undo) RecordControlUndo();
+            result = (int32_t)ExecuteCSR(inst, csr_write);
+            break;
+        }
+
+        // --- FLOATING POINT (RV32F/D, RISCV_CPU_Float.cpp) & VECTOR (RVV subset, RISCV_CPU_Vector.cpp) ---
+        case OpcodeType::LOAD_FP:
+        case OpcodeType::STORE_FP:
+        case OpcodeType::OP_FP:
+        case OpcodeType::MADD:
+        case OpcodeType::MSUB:
+        case OpcodeType::NMSUB:
+        case OpcodeType::NMADD:
+        case OpcodeType::OP_V: {
+            // LOAD-FP/STORE-FP are shared: width 2/3 is FLW/FLD (FSW/FSD), the rest are vector element widths
+            bool is_vector = op == OpcodeType::OP_V ||
+                             ((op == OpcodeType::LOAD_FP || op == OpcodeType::STORE_FP) && inst.funct3 != 0x2 && inst.funct3 != 0x3);
+            if (undo) {
+                if (is_vector) {
+                    RecordVectorUndo(inst);
+                } else {
+                    RecordFloatUndo(inst.rd);
+                }
+                bUndoStores = true; // FSD and vector stores can overwrite more than one record holds
+            }
+
+            uint32_t scalar = 0;
+            write_to_reg = is_vector ? ExecuteVector(inst, scalar) : ExecuteFloat(inst, scalar);
+            result = (int32_t)scalar;
+            bUndoStores = false;
+            break;
+        }
+
+        // --- FENCE / FENCE.I ---
+        // A hart always sees its own accesses in order, and a predecoded page is dropped
+        // once written, so only harts on other host threads need the fence
+        case OpcodeType::MISC_MEM:
             write_to_reg = false;
-            // Handle ECALL / EBREAK here later
+            if (inst.funct3 > 0x1) {
+                RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+                break;
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
             break;
 
         default:
-            // Illegal Instruction
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
             break;
     }
 
+    // A faulting instruction has no effect: no write-back, continue in the trap handler
+    if (bTrapPending) {
+        if (undo) RecordControlUndo();
+        TakeTrap();
+        CycleCount++;
+        return;
+    }
+
     // ==========================================================
     // 3. WRITE BACK (The "RegWrite" Logic)
     // ==========================================================
     // Rule: Never write to x0.
     if (inst.rd != 0 && write_to_reg) {
+        if (undo) {
+            undo->Rd = (uint8_t)inst.rd;
+            undo->PrevRdValue = Registers[inst.rd];
+        }
         Registers[inst.rd] = (uint32_t)result;
     }
 
@@ -320,26 +483,52 @@ void RISCV_CPU::Execute(DecodedInstruction& inst) {
     // 4. PC UPDATE
     // ==========================================================
     PC = next_pc;
+    CycleCount++;
 }
 
 uint32_t RISCV_CPU::MemRead(uint32_t addr, int size, bool signed_extend) {
-    // 1. Bounds Check (Prevent crashing if address is out of range)
-    if (addr + size > MEMORY_SIZE) {
-        std::cerr << "Error: Memory Read Out of Bounds at " << std::hex << addr << std::endl;
-        return 0;
+    uint32_t value = 0;
+
+    // 0. Virtual memory: a TLB hit costs one compare. An access crossing into the
+    //    next page is done a byte at a time, since the two pages can map anywhere.
+    uint32_t paddr = addr;
+    bool split = false;
+    if (bTranslate) {
+        if ((addr & (PAGE_SIZE - 1)) > PAGE_SIZE - size) {
+            split = true;
+            for (int i = 0; i < size && !bTrapPending; i++) {
+                value |= MemRead(addr + i, 1, false) << (i * 8);
+            }
+        } else if (!Translate(paddr, ACCESS_LOAD)) {
+            return 0; // Page fault raised
+        }
     }
 
-    uint32_t value = 0;
+    // 1. Bounds Check. Anything outside RAM is routed to the device bus, so a
+    //    normal RAM access costs nothing more than this single comparison.
+    //    (Written as a subtraction so addresses near 0xFFFFFFFF cannot wrap around.)
+    if (split) {
+        // Already read above
+    } else if (paddr > MEMORY_SIZE - size) {
+        if (!Bus.Read(paddr, size, CycleCount, value)) {
+            std::cerr << "Error: Memory Read Out of Bounds at " << std::hex << paddr << std::endl;
+            return 0;
+        }
+    } else {
+        if (!LoadIfPending(paddr, size)) {
+            RaiseTrap(CAUSE_LOAD_ACCESS_FAULT, addr);
+            return 0;
+        }
+        if (TraceSink) TraceSink->OnAccess(paddr, size, RISCV_TraceSink::Load);
 
-    // 2. Read Bytes (Little Endian: LSB at addr)
-    for (int i = 0; i < size; i++) {
-        value |= ((uint32_t)Memory[addr + i]) << (i * 8);
+        // 2. Read Bytes (Little Endian: LSB at addr)
+        value = LoadRAM(paddr, size);
     }
 
     // 3. Sign Extension (If requested)
     // If accessing Byte (8-bit) and the 8th bit is 1, fill upper bits.
     // If accessing Half (16-bit) and the 16th bit is 1, fill upper bits.
-    if (signed_extend) {
+    if (signed_extend && size < 4) {
         int bit_width = size * 8;
         // Check if the MSB (Sign bit) is set
         if ((value >> (bit_width - 1)) & 1) {
@@ -350,32 +539,447 @@ uint32_t RISCV_CPU::MemRead(uint32_t addr, int size, bool signed_extend) {
         }
     }
 
+    // 4. Watched page? (the only cost a debugger adds to unwatched accesses; virtual addresses)
+    if (WatchPageFlags[(addr >> PAGE_SHIFT) & WATCH_PAGE_MASK] & WATCH_READ) {
+        CheckWatchpoints(addr, size, value, false);
+    }
+
     return value;
 }
 
 void RISCV_CPU::MemWrite(uint32_t addr, uint32_t data, int size) {
-    // 1. Bounds Check
-    if (addr + size > MEMORY_SIZE) {
-        std::cerr << "Error: Memory Write Out of Bounds at " << std::hex << addr << std::endl;
+    uint32_t vaddr = addr; // Watchpoints work on virtual addresses
+
+    // 0. Virtual memory (see MemRead). A split store checks both pages first, so a
+    //    fault on the second page leaves memory untouched.
+    if (bTranslate && (addr & (PAGE_SIZE - 1)) > PAGE_SIZE - size) {
+        uint32_t first = addr;
+        uint32_t last = addr + size - 1;
+        if (!Translate(first, ACCESS_STORE) || !Translate(last, ACCESS_STORE)) return;
+        for (int i = 0; i < size; i++) {
+            uint32_t byte_addr = addr + i;
+            Translate(byte_addr, ACCESS_STORE);
+            MemWritePhysical(byte_addr, (data >> (i * 8)) & 0xFF, 1);
+        }
+    } else {
+        if (bTranslate && !Translate(addr, ACCESS_STORE)) return; // Page fault raised
+        MemWritePhysical(addr, data, size);
+    }
+    if (bTrapPending) return; // The page could not be loaded
+
+    // Watched page? Checked once the store went through, so a faulting store is not a hit
+    if (WatchPageFlags[(vaddr >> PAGE_SHIFT) & WATCH_PAGE_MASK] & WATCH_WRITE) {
+        CheckWatchpoints(vaddr, size, data, true);
+    }
+}
+
+void RISCV_CPU::MemWritePhysical(uint32_t addr, uint32_t data, int size) {
+    // 1. Bounds Check (Devices live outside RAM)
+    if (addr > MEMORY_SIZE - size) {
+        WriteCount++;
+        if (!Bus.Write(addr, data, size, CycleCount)) {
+            std::cerr << "Error: Memory Write Out of Bounds at " << std::hex << addr << std::endl;
+        }
+        return;
+    }
+
+    if (!LoadIfPending(addr, size)) {
+        RaiseTrap(CAUSE_STORE_ACCESS_FAULT, addr);
         return;
     }
+    if (TraceSink) TraceSink->OnAccess(addr, size, RISCV_TraceSink::Store);
+    if (bUndoStores) RecordMemoryUndo(addr, size);
+
+    // 2. Remember the page(s) for Reset(), and break other harts' reservations
+    MarkWritten(addr, size);
+    NoteStore(addr, size);
+
+    // 3. Write Bytes (Little Endian)
+    StoreRAM(addr, data, size);
+}
+
+void RISCV_CPU::ClearReservation() {
+    if (!bReservationValid) return;
+    bReservationValid = false;
+    Mem->ActiveReservations.fetch_sub(1);
+}
+
+void RISCV_CPU::BumpStoreStamps(uint32_t addr, uint32_t size) {
+    uint32_t last = (addr + size - 1) >> 2;
+    for (uint32_t word = addr >> 2; word <= last; word++) {
+        Mem->StoreStamps[word & (GuestMemory::STAMP_BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t RISCV_CPU::ExecuteAtomic(const DecodedInstruction& inst, uint32_t addr, uint32_t src, UndoRecord* undo) {
+    uint32_t funct5 = inst.funct7 >> 2;
+    uint32_t vaddr = addr; // Watchpoints and the undo log work on virtual addresses
+
+    bool is_lr = funct5 == 0x02;
+
+    // RV32A only has word atomics, and only naturally aligned ones
+    bool known = false;
+    switch (funct5) {
+        case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x08:
+        case 0x0C: case 0x10: case 0x14: case 0x18: case 0x1C:
+            known = true;
+            break;
+        default:
+            break;
+    }
+    if (!known || inst.funct3 != 0x2) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return 0;
+    }
+    if (addr & 0x3) {
+        RaiseTrap(is_lr ? CAUSE_LOAD_MISALIGNED : CAUSE_STORE_MISALIGNED, vaddr);
+        return 0;
+    }
 
-    // 2. Write Bytes (Little Endian)
-    // We take the bottom 8 bits, write them, shift data right, repeat.
-    for (int i = 0; i < size; i++) {
-        Memory[addr + i] = (data >> (i * 8)) & 0xFF;
+    // Virtual memory: LR is a load, everything else needs store permission
+    if (bTranslate && !Translate(addr, is_lr ? ACCESS_LOAD : ACCESS_STORE)) {
+        return 0; // Page fault raised
+    }
+
+    // Atomics only work on RAM, not on devices
+    if (addr > MEMORY_SIZE - 4) {
+        RaiseTrap(is_lr ? CAUSE_LOAD_ACCESS_FAULT : CAUSE_STORE_ACCESS_FAULT, vaddr);
+        return 0;
+    }
+
+    // Guest memory is little endian, like every host we build for, so a guest
+    // word can be used directly as a host atomic. aq/rl are covered by seq_cst.
+    if (!LoadIfPending(addr, 4)) {
+        RaiseTrap(is_lr ? CAUSE_LOAD_ACCESS_FAULT : CAUSE_STORE_ACCESS_FAULT, vaddr);
+        return 0;
+    }
+    std::atomic_ref<uint32_t> word(*reinterpret_cast<uint32_t*>(Memory + addr));
+    if (TraceSink) TraceSink->OnAccess(addr, 4, RISCV_TraceSink::Store);
+
+    // Watchpoints see an AMO as a read and a write of the word (LR only reads it)
+    if (WatchPageFlags[(vaddr >> PAGE_SHIFT) & WATCH_PAGE_MASK] & (WATCH_READ | WATCH_WRITE)) {
+        CheckWatchpoints(vaddr, 4, word.load(), false);
+        if (funct5 != 0x02) CheckWatchpoints(vaddr, 4, src, true);
+    }
+
+    switch (funct5) {
+        case 0x02: { // LR.W
+            // Announce the reservation before sampling, so no store after the load goes unstamped
+            if (!bReservationValid) Mem->ActiveReservations.fetch_add(1);
+            ReservationStamp = Mem->StoreStamps[(addr >> 2) & (GuestMemory::STAMP_BUCKETS - 1)].load();
+            uint32_t value = word.load();
+            bReservationValid = true;
+            ReservationAddr = addr;
+            ReservationValue = value;
+            return value;
+        }
+
+        case 0x03: { // SC.W (rd = 0 on success, 1 on failure)
+            bool reserved = bReservationValid && ReservationAddr == addr;
+            if (!reserved) {
+                ClearReservation();
+                return 1;
+            }
+
+            if (undo) RecordStoreUndo(*undo, vaddr, 4);
+            MarkWritten(addr, 4);
+            // Fails if any store hit the word (or its stamp bucket) since our LR, or if the
+            // value changed. Only a store landing between these two checks can slip through.
+            uint32_t expected = ReservationValue;
+            bool stored = Mem->StoreStamps[(addr >> 2) & (GuestMemory::STAMP_BUCKETS - 1)].load() == ReservationStamp &&
+                          word.compare_exchange_strong(expected, src);
+            ClearReservation();
+            if (stored) NoteStore(addr, 4);
+            return stored ? 0 : 1;
+        }
+
+        default:
+            break;
+    }
+
+    // Read-modify-write AMOs (all return the old value)
+    if (undo) RecordStoreUndo(*undo, vaddr, 4);
+    MarkWritten(addr, 4);
+    NoteStore(addr, 4);
+
+    switch (funct5) {
+        case 0x01: return word.exchange(src);  // AMOSWAP.W
+        case 0x00: return word.fetch_add(src); // AMOADD.W
+        case 0x04: return word.fetch_xor(src); // AMOXOR.W
+        case 0x0C: return word.fetch_and(src); // AMOAND.W
+        case 0x08: return word.fetch_or(src);  // AMOOR.W
+
+        case 0x10:   // AMOMIN.W
+        case 0x14:   // AMOMAX.W
+        case 0x18:   // AMOMINU.W
+        case 0x1C: { // AMOMAXU.W
+            // No host instruction for these: compare-and-swap loop
+            uint32_t old_value = word.load();
+            uint32_t new_value;
+            do {
+                bool old_smaller = (funct5 <= 0x14) ? ((int32_t)old_value < (int32_t)src) : (old_value < src);
+                bool want_min = (funct5 == 0x10 || funct5 == 0x18);
+                new_value = (old_smaller == want_min) ? old_value : src;
+            } while (!word.compare_exchange_weak(old_value, new_value));
+            return old_value;
+        }
+
+        default:
+            return 0; // Rejected above
     }
 }
 
+uint32_t RISCV_CPU::ExecuteCSR(const DecodedInstruction& inst, bool writeCSR) {
+    uint32_t csr = inst.raw >> 20;
+    uint32_t src = (inst.funct3 & 0x4) ? inst.rs1 : Registers[inst.rs1]; // Immediate forms use rs1 as uimm
+
+    // CSR address bits 9:8 give the lowest privilege that may access it
+    if (((csr >> 8) & 0x3) > Privilege) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return 0;
+    }
+
+    uint32_t old_value = 0;
+    if (!ReadCSR(csr, old_value)) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw); // Unimplemented CSR
+        return 0;
+    }
+
+    if (writeCSR) {
+        uint32_t new_value = src;                                 // CSRRW
+        if ((inst.funct3 & 0x3) == 0x2) new_value = old_value | src;  // CSRRS
+        if ((inst.funct3 & 0x3) == 0x3) new_value = old_value & ~src; // CSRRC
+        if (!WriteCSR(csr, new_value)) {
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw); // Read-only CSR
+            return 0;
+        }
+    }
+    return old_value;
+}
+
+bool RISCV_CPU::ReadCSR(uint32_t csr, uint32_t& value) {
+    switch (csr) {
+        case CSR_CYCLE:   value = (uint32_t)CycleCount; return true;
+        case CSR_CYCLEH:  value = (uint32_t)(CycleCount >> 32); return true;
+        case CSR_TIME:    value = (uint32_t)Clint->GetTime(CycleCount); return true;
+        case CSR_TIMEH:   value = (uint32_t)(Clint->GetTime(CycleCount) >> 32); return true;
+        case CSR_MHARTID: value = HartId; return true;
+        case CSR_FFLAGS:  value = FFlags; return true;
+        case CSR_FRM:     value = FRM; return true;
+        case CSR_FCSR:    value = (FRM << 5) | FFlags; return true;
+        case CSR_VSTART:  value = VStart; return true;
+        case CSR_VL:      value = VL; return true;
+        case CSR_VTYPE:   value = VType; return true;
+        case CSR_VLENB:   value = VLENB; return true;
+        case CSR_SATP:    value = Satp; return true;
+        case CSR_MSTATUS: value = MStatus; return true;
+        case CSR_MTVEC:   value = MTvec; return true;
+        case CSR_MSCRATCH: value = MScratch; return true;
+        case CSR_MEPC:    value = MEpc; return true;
+        case CSR_MCAUSE:  value = MCause; return true;
+        case CSR_MTVAL:   value = MTval; return true;
+        default:          return false;
+    }
+}
+
+bool RISCV_CPU::WriteCSR(uint32_t csr, uint32_t value) {
+    // Read-only CSRs have 0b11 in their top two bits
+    if ((csr >> 10) == 0x3) return false;
+
+    switch (csr) {
+        case CSR_FFLAGS: FFlags = value & 0x1F; return true;
+        case CSR_FRM:    FRM = value & 0x7; return true;
+        case CSR_FCSR:   FFlags = value & 0x1F; FRM = (value >> 5) & 0x7; return true;
+        case CSR_VSTART: VStart = value; return true;
+        case CSR_SATP:   Satp = value & 0x803FFFFF; FlushTLB(); UpdateTranslation(); return true; // MODE + PPN (no ASIDs)
+        case CSR_MSTATUS: {
+            if ((value & MSTATUS_MPP) == (2u << 11)) value &= ~MSTATUS_MPP; // MPP = 2 is reserved; read back as U
+            if ((MStatus ^ value) & (MSTATUS_SUM | MSTATUS_MXR)) FlushTLB(); // The TLB tags hold permission results
+            MStatus = value & MSTATUS_MASK;
+            return true;
+        }
+        case CSR_MTVEC:  MTvec = value & ~0x3u; return true; // Direct mode only
+        case CSR_MSCRATCH: MScratch = value; return true;
+        case CSR_MEPC:   MEpc = value & ~0x3u; return true;
+        case CSR_MCAUSE: MCause = value; return true;
+        case CSR_MTVAL:  MTval = value; return true;
+        default:         return false;
+    }
+}
+
+// --- Traps ---
+
+void RISCV_CPU::RaiseTrap(uint32_t cause, uint32_t tval) {
+    if (bTrapPending) return;
+    bTrapPending = true;
+    PendingCause = cause;
+    PendingTval = tval;
+}
+
+void RISCV_CPU::TakeTrap() {
+    bTrapPending = false;
+    MEpc = PC;
+    MCause = PendingCause;
+    MTval = PendingTval;
+
+    // Stack the interrupt enable and privilege: MPIE = MIE, MIE = 0, MPP = old mode
+    uint32_t mpie = (MStatus & MSTATUS_MIE) ? MSTATUS_MPIE : 0;
+    MStatus = (MStatus & ~(MSTATUS_MIE | MSTATUS_MPIE | MSTATUS_MPP)) | mpie | (Privilege << 11);
+
+    if (Privilege != PRIV_M) FlushTLB(); // The TLB tags hold permission results for the old mode
+    Privilege = PRIV_M;
+    UpdateTranslation();
+
+    PC = MTvec;
+    WriteCount++; // Not an idle loop, even if the handler jumps backwards
+}
+
+void RISCV_CPU::ReturnFromTrap() {
+    uint32_t mpp = (MStatus & MSTATUS_MPP) >> 11;
+    uint32_t mie = (MStatus & MSTATUS_MPIE) ? MSTATUS_MIE : 0;
+    MStatus = (MStatus & ~(MSTATUS_MIE | MSTATUS_MPP)) | mie | MSTATUS_MPIE; // MPP = U
+
+    if (mpp != Privilege) FlushTLB();
+    Privilege = mpp;
+    UpdateTranslation();
+
+    PC = MEpc;
+    WriteCount++;
+}
+
+void RISCV_CPU::ResetPrivilegedState() {
+    Privilege = PRIV_M;
+    MStatus = 0;
+    MTvec = 0;
+    MEpc = 0;
+    MCause = 0;
+    MTval = 0;
+    MScratch = 0;
+    bTrapPending = false;
+    PendingCause = 0;
+    PendingTval = 0;
+    Satp = 0;
+    FlushTLB();
+    UpdateTranslation();
+}
+
+// --- Virtual Memory (Sv32) ---
+
+namespace {
+    constexpr uint32_t PTE_V = 1 << 0;
+    constexpr uint32_t PTE_R = 1 << 1;
+    constexpr uint32_t PTE_W = 1 << 2;
+    constexpr uint32_t PTE_X = 1 << 3;
+    constexpr uint32_t PTE_U = 1 << 4;
+    constexpr uint32_t PTE_A = 1 << 6;
+    constexpr uint32_t PTE_D = 1 << 7;
+}
+
+bool RISCV_CPU::WalkPageTable(uint32_t& addr, AccessType type) {
+    static const uint32_t fault_cause[3] = { CAUSE_LOAD_PAGE_FAULT, CAUSE_STORE_PAGE_FAULT, CAUSE_FETCH_PAGE_FAULT };
+
+    // Would this leaf allow an access of type 't' in the current mode?
+    auto allowed = [this](uint32_t pte, uint32_t t) {
+        if (!(pte & PTE_A)) return false;
+        if (Privilege == PRIV_U && !(pte & PTE_U)) return false;
+        if (Privilege == PRIV_S && (pte & PTE_U) && (t == ACCESS_FETCH || !(MStatus & MSTATUS_SUM))) return false;
+        switch (t) {
+            case ACCESS_LOAD:  return (pte & PTE_R) || ((MStatus & MSTATUS_MXR) && (pte & PTE_X));
+            case ACCESS_STORE: return (pte & PTE_W) && (pte & PTE_D);
+            default:           return (pte & PTE_X) != 0;
+        }
+    };
+
+    uint32_t vaddr = addr;
+    uint32_t vpn = vaddr >> PAGE_SHIFT;
+    uint32_t table_ppn = Satp & 0x3FFFFF;
+
+    for (int level = 1; level >= 0; level--) {
+        // Page tables must live in RAM (physical addresses above 4 GiB do not exist here)
+        uint32_t pte_addr = (table_ppn << PAGE_SHIFT) + ((vpn >> (10 * level)) & 0x3FF) * 4;
+        if (table_ppn >= (1u << 20) || pte_addr > MEMORY_SIZE - 4) break;
+        if (!LoadIfPending(pte_addr, 4)) break;
+
+        // Other harts may be setting A/D bits in the same table
+        std::atomic_ref<uint32_t> pte_ref(*reinterpret_cast<uint32_t*>(Memory + pte_addr));
+        uint32_t pte = pte_ref.load();
+        if (TraceSink) TraceSink->OnAccess(pte_addr, 4, RISCV_TraceSink::Load);
+        if (!(pte & PTE_V) || ((pte & PTE_W) && !(pte & PTE_R))) break;
+
+        uint32_t ppn = pte >> 10;
+        if (!(pte & (PTE_R | PTE_X))) { // Pointer to the next level
+            table_ppn = ppn;
+            continue;
+        }
+
+        // Leaf. A superpage must be 4 MiB aligned.
+        if (level == 1 && (ppn & 0x3FF)) break;
+        if (ppn >= (1u << 20)) break;
+
+        // Check without A/D first, then set them the way hardware does (a store also needs D)
+        uint32_t needed = PTE_A | (type == ACCESS_STORE ? PTE_D : 0);
+        if (!allowed(pte | needed, type)) break;
+        if ((pte & needed) != needed) {
+            pte = pte_ref.fetch_or(needed) | needed;
+            MarkWritten(pte_addr, 4);
+        }
+
+        uint32_t phys_page = (level == 1) ? ((ppn | (vpn & 0x3FF)) << PAGE_SHIFT) : (ppn << PAGE_SHIFT);
+        if (level == 1) bTLBHasSuperpages = true;
+
+        TLBEntry& entry = TLB[vpn & (TLB_ENTRIES - 1)];
+        for (uint32_t t = 0; t < 3; t++) {
+            entry.Tag[t] = allowed(pte, t) ? vpn : TLB_INVALID;
+        }
+        entry.PhysPage = phys_page;
+
+        addr = phys_page | (vaddr & (PAGE_SIZE - 1));
+        return true;
+    }
+
+    RaiseTrap(fault_cause[type], vaddr);
+    return false;
+}
+
+void RISCV_CPU::FlushTLB() {
+    for (TLBEntry& entry : TLB) {
+        entry.Tag[ACCESS_LOAD] = entry.Tag[ACCESS_STORE] = entry.Tag[ACCESS_FETCH] = TLB_INVALID;
+    }
+    bTLBHasSuperpages = false;
+}
+
+void RISCV_CPU::FlushTLBAddress(uint32_t vaddr) {
+    // A cached superpage can cover this address from any slot
+    if (bTLBHasSuperpages) {
+        FlushTLB();
+        return;
+    }
+    TLBEntry& entry = TLB[(vaddr >> PAGE_SHIFT) & (TLB_ENTRIES - 1)];
+    entry.Tag[ACCESS_LOAD] = entry.Tag[ACCESS_STORE] = entry.Tag[ACCESS_FETCH] = TLB_INVALID;
+}
+
+void RISCV_CPU::UpdateTranslation() {
+    bTranslate = (Satp >> 31) && Privilege != PRIV_M;
+}
+
 uint32_t RISCV_CPU::GetRegisterValue(int reg_index) const {
     if (reg_index < 0 || reg_index > 31) return 0;
     return Registers[reg_index];
 }
 
+void RISCV_CPU::SetRegisterValue(int reg_index, uint32_t value) {
+    if (reg_index <= 0 || reg_index > 31) return; // x0 stays zero
+    Registers[reg_index] = value;
+}
+
 uint32_t RISCV_CPU::GetPC() const {
     return PC;
 }
 
+void RISCV_CPU::SetPC(uint32_t pc) {
+    PC = pc;
+}
+
 void RISCV_CPU::DebugDump() {
     std::cout << " [State] PC:" << PC 
               << " x1:" << Registers[1] 
@@ -383,66 +987,852 @@ void RISCV_CPU::DebugDump() {
               << " x3:" << Registers[3] << std::endl;
 }
 
+RISCV_Bus& RISCV_CPU::GetBus() {
+    return Bus;
+}
+
+RISCV_UART& RISCV_CPU::GetUART() {
+    return *Uart;
+}
+
+RISCV_CLINT& RISCV_CPU::GetCLINT() {
+    return *Clint;
+}
+
+uint64_t RISCV_CPU::GetCycleCount() const {
+    return CycleCount;
+}
+
+uint64_t RISCV_CPU::RunFor(uint64_t maxInstructions) {
+    uint64_t executed = 0;
+    Stop = StopInfo{};
+    bStopRequested = false;
+    if (bHalted) {
+        Stop.Reason = StopReason::Halted;
+        Stop.PC = PC;
+        return 0;
+    }
+
+    while (executed < maxInstructions) {
+        // Stalled: nothing to interpret, so jump to whatever can happen next
+        if (StallCycle > CycleCount) {
+            uint64_t wake = StallCycle;
+            if (Scheduler) wake = std::min(wake, Scheduler->PeekNextDue());
+            if (wake == UINT64_MAX) { // Stalled forever with nothing scheduled
+                Stop.Reason = StopReason::Stalled;
+                Stop.PC = PC;
+                break;
+            }
+
+            CycleCount = std::max(CycleCount, wake);
+            bIdleSnapshotValid = false;
+        }
+
+        // Fire due events (a callback may stall the core again, so re-check)
+        if (Scheduler && CycleCount >= Scheduler->PeekNextDue()) {
+            Scheduler->RunUntil(CycleCount);
+            bIdleSnapshotValid = false; // Events can change what the guest is waiting on
+            continue;
+        }
+
+        uint32_t pc = PC;
+        if ((WatchPageFlags[(pc >> PAGE_SHIFT) & WATCH_PAGE_MASK] & WATCH_EXEC) && executed > 0 &&
+            std::find(Breakpoints.begin(), Breakpoints.end(), pc) != Breakpoints.end()) {
+            Stop.Reason = StopReason::Breakpoint;
+            Stop.PC = pc;
+            break;
+        }
+
+        const DecodedInstruction* predecoded = LookupPredecoded(pc);
+        DecodedInstruction decoded = predecoded ? *predecoded : Decode(FetchInstruction());
+        Execute(decoded);
+        executed++;
+
+        if (bStopRequested) break; // Watchpoint hit, or the hart halted
+
+        // A backward (or self) jump ends a loop iteration
+        if (PC <= pc && bIdleSkipEnabled) {
+            executed += SkipIdleLoop(maxInstructions - executed);
+        }
+    }
+
+    // Events only fire as they come due, so the scheduler's clock lags behind until told
+    if (Scheduler) Scheduler->RunUntil(CycleCount);
+    return executed;
+}
+
+void RISCV_CPU::ResetIdleDetection() {
+    bIdleSnapshotValid = false;
+    IdleLoopHead = 0;
+    IdleWriteCount = 0;
+    IdleSnapshotCycle = 0;
+    IdleBackoff = 0;
+    IdleBackoffLength = 1;
+}
+
+uint64_t RISCV_CPU::SkipIdleLoop(uint64_t budget) {
+    // Skipped iterations would never reach the breakpoint and watchpoint checks
+    if (!Breakpoints.empty() || !Watchpoints.empty()) return 0;
+    if (TraceSink) return 0; // The trace must see every iteration
+    if (bUndoEnabled) return 0; // Every instruction needs its undo record
+
+    if (IdleBackoff > 0) {
+        IdleBackoff--;
+        return 0;
+    }
+
+    // 1. No snapshot yet: take one at this loop head
+    if (!bIdleSnapshotValid) {
+        bIdleSnapshotValid = true;
+        IdleLoopHead = PC;
+        IdleWriteCount = WriteCount;
+        IdleSnapshotCycle = CycleCount;
+        std::copy(Registers, Registers + 32, IdleRegisters);
+        return 0;
+    }
+
+    // 2. Did the last iteration make any progress?
+    bool idle = IdleLoopHead == PC && IdleWriteCount == WriteCount && std::equal(Registers, Registers + 32, IdleRegisters);
+    if (!idle) {
+        bIdleSnapshotValid = false;
+        IdleBackoffLength = std::min(IdleBackoffLength * 2, 1024u);
+        IdleBackoff = IdleBackoffLength;
+        return 0;
+    }
+    IdleBackoffLength = 1;
+
+    // 3. Every further iteration is identical: skip whole iterations until something
+    //    outside the loop can change (next event or timer deadline) or the budget runs out
+    uint64_t iteration = CycleCount - IdleSnapshotCycle;
+    if (iteration == 0) return 0;
+
+    uint64_t wake = UINT64_MAX;
+    if (Scheduler) wake = std::min(wake, Scheduler->PeekNextDue());
+    uint64_t deadline = Clint->GetTimerDeadline(HartId);
+    if (deadline > CycleCount) wake = std::min(wake, deadline);
+
+    uint64_t iterations = budget / iteration;
+    if (wake != UINT64_MAX) {
+        iterations = std::min(iterations, wake > CycleCount ? (wake - CycleCount) / iteration : 0);
+    }
+
+    uint64_t skipped = iterations * iteration; // One cycle per instruction
+    CycleCount += skipped;
+    SkippedCycles += skipped;
+    IdleSnapshotCycle = CycleCount;
+    return skipped;
+}
+
+void RISCV_CPU::EnableIdleSkip(bool enable) {
+    bIdleSkipEnabled = enable;
+    ResetIdleDetection();
+}
+
+uint64_t RISCV_CPU::GetSkippedCycles() const {
+    return SkippedCycles;
+}
+
+void RISCV_CPU::AddBreakpoint(uint32_t pc) {
+    if (std::find(Breakpoints.begin(), Breakpoints.end(), pc) == Breakpoints.end()) {
+        Breakpoints.push_back(pc);
+        FlagWatchRange(pc, 4, WATCH_EXEC);
+    }
+}
+
+bool RISCV_CPU::RemoveBreakpoint(uint32_t pc) {
+    auto found = std::find(Breakpoints.begin(), Breakpoints.end(), pc);
+    if (found == Breakpoints.end()) return false;
+
+    Breakpoints.erase(found);
+    RebuildWatchFlags();
+    return true;
+}
+
+void RISCV_CPU::AddWatchpoint(uint32_t addr, uint32_t size, WatchType type) {
+    if (size == 0) return;
+    Watchpoints.push_back({ addr, size, type });
+    if ((uint8_t)type & (uint8_t)WatchType::Read)  FlagWatchRange(addr, size, WATCH_READ);
+    if ((uint8_t)type & (uint8_t)WatchType::Write) FlagWatchRange(addr, size, WATCH_WRITE);
+}
+
+bool RISCV_CPU::RemoveWatchpoint(uint32_t addr, uint32_t size) {
+    auto found = std::find_if(Watchpoints.begin(), Watchpoints.end(),
+                              [&](const Watchpoint& w) { return w.Addr == addr && w.Size == size; });
+    if (found == Watchpoints.end()) return false;
+
+    Watchpoints.erase(found);
+    RebuildWatchFlags();
+    return true;
+}
+
+void RISCV_CPU::ClearBreakpoints() {
+    Breakpoints.clear();
+    Watchpoints.clear();
+    RebuildWatchFlags();
+}
+
+void RISCV_CPU::AttachPredecoded(const DecodedInstruction* entries, uint32_t base, uint32_t count) {
+    // Only RAM can be predecoded (the dirty flags say whether it still holds the image)
+    if (!entries || base >= MEMORY_SIZE) count = 0;
+    count = std::min(count, (MEMORY_SIZE - base) / 4);
+
+    Predecoded = entries;
+    PredecodedBase = base;
+    PredecodedCount = count;
+}
+
+void RISCV_CPU::SetTraceSink(RISCV_TraceSink* sink) {
+    TraceSink = sink;
+}
+
+const StopInfo& RISCV_CPU::GetStopInfo() const {
+    return Stop;
+}
+
+void RISCV_CPU::RebuildWatchFlags() {
+    std::fill(WatchPageFlags, WatchPageFlags + NUM_PAGES, 0);
+    for (uint32_t pc : Breakpoints) {
+        FlagWatchRange(pc, 4, WATCH_EXEC);
+    }
+    for (const Watchpoint& w : Watchpoints) {
+        if ((uint8_t)w.Type & (uint8_t)WatchType::Read)  FlagWatchRange(w.Addr, w.Size, WATCH_READ);
+        if ((uint8_t)w.Type & (uint8_t)WatchType::Write) FlagWatchRange(w.Addr, w.Size, WATCH_WRITE);
+    }
+}
+
+void RISCV_CPU::FlagWatchRange(uint32_t addr, uint32_t size, uint8_t flag) {
+    // The fast path only tests the page of an access's first byte, so an access that
+    // starts up to 3 bytes before the range (and may cross into it) must see a flag too
+    uint64_t first = (addr >= 3) ? addr - 3 : 0;
+    uint64_t last = (uint64_t)addr + size - 1;
+    if (last - first >= MEMORY_SIZE) { // Covers every page anyway
+        first = 0;
+        last = MEMORY_SIZE - 1;
+    }
+    for (uint64_t page = first >> PAGE_SHIFT; page <= (last >> PAGE_SHIFT); page++) {
+        WatchPageFlags[page & WATCH_PAGE_MASK] |= flag;
+    }
+}
+
+void RISCV_CPU::CheckWatchpoints(uint32_t addr, uint32_t size, uint32_t value, bool isWrite) {
+    if (bStopRequested) return; // Report the first hit only
+
+    uint8_t wanted = isWrite ? (uint8_t)WatchType::Write : (uint8_t)WatchType::Read;
+    for (const Watchpoint& w : Watchpoints) {
+        bool overlaps = (uint64_t)addr < (uint64_t)w.Addr + w.Size && (uint64_t)w.Addr < (uint64_t)addr + size;
+        if (overlaps && ((uint8_t)w.Type & wanted)) {
+            Stop = { StopReason::Watchpoint, PC, addr, size, value, isWrite };
+            bStopRequested = true;
+            return;
+        }
+    }
+}
+
+void RISCV_CPU::AttachScheduler(RISCV_EventScheduler* scheduler) {
+    Scheduler = scheduler;
+}
+
+RISCV_EventScheduler* RISCV_CPU::GetScheduler() {
+    return Scheduler;
+}
+
+void RISCV_CPU::StallUntil(uint64_t cycle) {
+    StallCycle = cycle;
+}
+
+void RISCV_CPU::EnableUndoLog(bool enable, size_t maxChunks) {
+    bUndoEnabled = enable;
+    UndoLog.SetMaxChunks(maxChunks);
+    if (!enable) {
+        UndoLog.Clear();
+        UndoCheckpoints.clear();
+    }
+}
+
+void RISCV_CPU::RecordStoreUndo(UndoRecord& undo, uint32_t addr, int size) {
+    // The record holds a physical address. A store that crosses a page boundary
+    // under translation touches two unrelated pages, so it saves each byte as extra state.
+    if (bTranslate) {
+        if ((addr & (PAGE_SIZE - 1)) > PAGE_SIZE - size) {
+            bUndoStores = true;
+            return;
+        }
+        if (!Translate(addr, ACCESS_STORE)) return; // Will fault, so nothing is written
+    }
+
+    // Device registers have side effects and cannot be rewound - only RAM is recorded
+    if (addr > MEMORY_SIZE - size) return;
+    if (!LoadIfPending(addr, size)) return; // Will fault, so nothing is written
+
+    undo.StoreAddr = addr;
+    undo.StoreOldBytes = LoadRAM(addr, size);
+    undo.StoreSize = (uint8_t)size;
+}
+
+namespace {
+    // Saved by RecordControlUndo: everything a CSR write, MRET or trap can change
+    struct UndoControlState {
+        uint32_t Privilege, MStatus, MTvec, MEpc, MCause, MTval, MScratch, Satp, FFlags, FRM, VStart;
+    };
+}
+
+void RISCV_CPU::RecordFloatUndo(uint32_t reg) {
+    uint8_t entry[11] = { UNDO_FREG, (uint8_t)reg, (uint8_t)FFlags };
+    std::memcpy(entry + 3, &FRegs[reg], sizeof(uint64_t));
+    UndoLog.AppendExtra(entry, sizeof(entry));
+}
+
+void RISCV_CPU::RecordMemoryUndo(uint32_t addr, uint32_t size) {
+    uint8_t entry[7] = { UNDO_MEMORY };
+    uint16_t size16 = (uint16_t)size;
+    std::memcpy(entry + 1, &addr, sizeof(addr));
+    std::memcpy(entry + 5, &size16, sizeof(size16));
+    UndoLog.AppendExtra(entry, sizeof(entry));
+    UndoLog.AppendExtra(Memory + addr, size);
+}
+
+void RISCV_CPU::RecordControlUndo() {
+    UndoControlState state = { Privilege, MStatus, MTvec, MEpc, MCause, MTval, MScratch, Satp, FFlags, FRM, VStart };
+    uint8_t kind = UNDO_CONTROL;
+    UndoLog.AppendExtra(&kind, 1);
+    UndoLog.AppendExtra(&state, sizeof(state));
+}
+
+void RISCV_CPU::ApplyExtraUndo(const std::vector<uint8_t>& extra) {
+    // Find where each entry starts, then undo them newest first (a strided
+    // vector store may have overwritten the same bytes more than once)
+    std::vector<size_t> entries;
+    for (size_t pos = 0; pos < extra.size();) {
+        entries.push_back(pos);
+        switch (extra[pos]) {
+            case UNDO_FREG:    pos += 11; break;
+            case UNDO_VREGS:   pos += 3 + (size_t)extra[pos + 2] * VLENB; break;
+            case UNDO_VCONFIG: pos += 13; break;
+            case UNDO_MEMORY: {
+                uint16_t size;
+                std::memcpy(&size, &extra[pos + 5], sizeof(size));
+                pos += 7 + size;
+                break;
+            }
+            case UNDO_CONTROL: pos += 1 + sizeof(UndoControlState); break;
+            default:           pos = extra.size(); break;
+        }
+    }
+
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        const uint8_t* entry = &extra[*it];
+        switch (entry[0]) {
+            case UNDO_FREG:
+                FFlags = entry[2];
+                std::memcpy(&FRegs[entry[1]], entry + 3, sizeof(uint64_t));
+                break;
+            case UNDO_VREGS:
+                std::memcpy(VectorRegs + entry[1] * VLENB, entry + 3, (size_t)entry[2] * VLENB);
+                break;
+            case UNDO_VCONFIG:
+                std::memcpy(&VL, entry + 1, 4);
+                std::memcpy(&VType, entry + 5, 4);
+                std::memcpy(&VStart, entry + 9, 4);
+                break;
+            case UNDO_MEMORY: {
+                uint32_t addr;
+                uint16_t size;
+                std::memcpy(&addr, entry + 1, sizeof(addr));
+                std::memcpy(&size, entry + 5, sizeof(size));
+                NoteStore(addr, size);
+                std::memcpy(Memory + addr, entry + 7, size);
+                break;
+            }
+            case UNDO_CONTROL: {
+                UndoControlState state;
+                std::memcpy(&state, entry + 1, sizeof(state));
+                Privilege = state.Privilege;
+                MStatus = state.MStatus;
+                MTvec = state.MTvec;
+                MEpc = state.MEpc;
+                MCause = state.MCause;
+                MTval = state.MTval;
+                MScratch = state.MScratch;
+                Satp = state.Satp;
+                FFlags = state.FFlags;
+                FRM = state.FRM;
+                VStart = state.VStart;
+                FlushTLB(); // The TLB tags hold permission results for the old mode and satp
+                UpdateTranslation();
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void RISCV_CPU::ApplyUndo(const UndoRecord& undo, const std::vector<uint8_t>& extra) {
+    if (undo.ExtraSize) {
+        ApplyExtraUndo(extra);
+    }
+    if (undo.StoreSize) {
+        NoteStore(undo.StoreAddr, undo.StoreSize);
+        StoreRAM(undo.StoreAddr, undo.StoreOldBytes, undo.StoreSize);
+    }
+    if (undo.Rd != 0) {
+        Registers[undo.Rd] = undo.PrevRdValue;
+    }
+    PC = undo.PrevPC;
+    CycleCount--;
+
+    // Any undone instruction comes before the one that halted or stopped the hart
+    bHalted = false;
+    Stop = StopInfo{};
+}
+
+void RISCV_CPU::SaveUndoCheckpoint() {
+    uint64_t index = UndoLog.GetEndIndex();
+    if (!UndoCheckpoints.empty() && UndoCheckpoints.back().Index == index) return; // Kept from before a replay
+    UndoCheckpoints.push_back({ index, SaveCheckpoint() });
+
+    // Keep as many checkpoints again as the log has chunks. Past that, thin out every other
+    // one whose records are gone, so old history stays reachable at a coarser spacing.
+    if (UndoCheckpoints.size() > 2 * UndoLog.GetMaxChunks()) {
+        uint64_t begin = UndoLog.GetBeginIndex();
+        bool drop = false;
+        for (auto it = UndoCheckpoints.begin(); it != UndoCheckpoints.end() && it->Index < begin;) {
+            it = drop ? UndoCheckpoints.erase(it) : it + 1;
+            drop = !drop;
+        }
+    }
+}
+
+void RISCV_CPU::ReplayStep() {
+    DecodedInstruction decoded = Decode(FetchInstruction());
+    Execute(decoded);
+}
+
+void RISCV_CPU::RewindTo(uint64_t index) {
+    // Within the recorded window: undo record by record
+    if (index >= UndoLog.GetBeginIndex()) {
+        while (UndoLog.GetEndIndex() > index) {
+            UndoRecord undo = UndoLog.Pop(UndoExtra);
+            ApplyUndo(undo, UndoExtra);
+        }
+        return;
+    }
+
+    // Older: restore the last checkpoint at or before it and replay from there. The
+    // replay records the history again, and takes the later checkpoints again.
+    while (UndoCheckpoints.size() > 1 && UndoCheckpoints.back().Index > index) {
+        UndoCheckpoints.pop_back();
+    }
+    if (UndoCheckpoints.empty()) return;
+
+    uint64_t start = UndoCheckpoints.back().Index;
+    RestoreImagePages();
+    LoadCheckpointState(UndoCheckpoints.back().State);
+    ClearReservation();
+    ResetIdleDetection();
+    StallCycle = 0;
+    Stop = StopInfo{};
+    UndoLog.Clear(start);
+
+    for (uint64_t i = start; i < index; i++) {
+        ReplayStep();
+    }
+}
+
+uint64_t RISCV_CPU::StepBack(uint64_t count) {
+    uint64_t end = UndoLog.GetEndIndex();
+    uint64_t target = end - std::min(count, GetUndoDepth());
+    RewindTo(target);
+    return end - target;
+}
+
+bool RISCV_CPU::RunBackwardUntil(uint32_t targetPC) {
+    while (!UndoLog.IsEmpty()) {
+        UndoRecord undo = UndoLog.Pop(UndoExtra);
+        ApplyUndo(undo, UndoExtra);
+        if (PC == targetPC) return true;
+    }
+
+    // Older history: replay it one checkpoint interval at a time, newest first,
+    // and stop at the last point in the interval where the PC was at the target
+    while (!UndoCheckpoints.empty() && UndoCheckpoints.front().Index < UndoLog.GetEndIndex()) {
+        uint64_t end = UndoLog.GetEndIndex();
+        uint64_t start = UndoCheckpoints.front().Index;
+        for (const UndoCheckpoint& checkpoint : UndoCheckpoints) {
+            if (checkpoint.Index < end) start = checkpoint.Index;
+        }
+
+        RewindTo(start);
+        uint64_t found = UINT64_MAX;
+        for (uint64_t index = start; index < end; index++) {
+            if (PC == targetPC) found = index;
+            ReplayStep();
+        }
+        if (found != UINT64_MAX) {
+            RewindTo(found);
+            return true;
+        }
+        RewindTo(start);
+    }
+    return false;
+}
+
+uint64_t RISCV_CPU::GetUndoDepth() const {
+    uint64_t earliest = UndoLog.GetBeginIndex();
+    if (!UndoCheckpoints.empty()) earliest = std::min(earliest, UndoCheckpoints.front().Index);
+    return UndoLog.GetEndIndex() - earliest;
+}
+
 uint32_t RISCV_CPU::FetchInstruction() {
-    
-    return MemRead(PC, 4, false);
+    // A fetch is not a data read, so it bypasses MemRead (and its read watchpoints)
+    uint32_t paddr = PC;
+    if (bTranslate && !Translate(paddr, ACCESS_FETCH)) {
+        return 0; // Page fault raised; 0 executes as nothing and Execute takes the trap
+    }
+
+    if (paddr > MEMORY_SIZE - 4) {
+        uint32_t value = 0;
+        if (!Bus.Read(paddr, 4, CycleCount, value)) {
+            std::cerr << "Error: Instruction Fetch Out of Bounds at " << std::hex << paddr << std::endl;
+        }
+        return value;
+    }
+    if (!LoadIfPending(paddr, 4)) {
+        RaiseTrap(CAUSE_FETCH_ACCESS_FAULT, PC);
+        return 0;
+    }
+    if (TraceSink) TraceSink->OnAccess(paddr, 4, RISCV_TraceSink::Fetch);
+    return LoadRAM(paddr, 4);
 }
 
 void RISCV_CPU::LoadMemory(const std::vector<uint8_t>& programData, uint32_t startAddr) {
-    for (size_t i = 0; i < programData.size(); i++) {
-        if (startAddr + i < MEMORY_SIZE) {
-            Memory[startAddr + i] = programData[i];
+    if (startAddr >= MEMORY_SIZE) return;
+    LoadPendingPages(); // Otherwise they would overwrite the program when first touched
+
+    // Clip the program to the end of RAM
+    size_t count = programData.size();
+    if (count > MEMORY_SIZE - startAddr) {
+        count = MEMORY_SIZE - startAddr;
+    }
+
+    std::copy(programData.begin(), programData.begin() + count, Memory + startAddr);
+    AttachPredecoded(nullptr, 0, 0); // May no longer match what is in RAM
+    Mem->LoadedImage.push_back({ startAddr, std::vector<uint8_t>(programData.begin(), programData.begin() + count),
+                                 HashImage(programData.data(), count, startAddr) });
+}
+
+uint64_t RISCV_CPU::HashImage(const uint8_t* bytes, size_t size, uint32_t startAddr) {
+    // xxHash64-style: four independent lanes of 8 bytes, so the multiplies overlap
+    // (about 20x faster than byte-wise FNV-1a), then a final avalanche
+    const uint64_t P1 = 0x9E3779B185EBCA87ull;
+    const uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t P3 = 0x165667B19E3779F9ull;
+    uint64_t seed = ((uint64_t)startAddr << 32) ^ size;
+
+    auto round = [&](uint64_t lane, uint64_t word) { return std::rotl(lane + word * P2, 31) * P1; };
+    auto load64 = [](const uint8_t* at) {
+        uint64_t word;
+        std::memcpy(&word, at, sizeof(word)); // Host byte order: the hash is only compared on this host
+        return word;
+    };
+
+    uint64_t lanes[4] = { seed + P1 + P2, seed + P2, seed, seed - P1 };
+    size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        for (int i = 0; i < 4; i++) {
+            lanes[i] = round(lanes[i], load64(bytes + pos + i * 8));
         }
     }
+    uint64_t hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+
+    for (; pos + 8 <= size; pos += 8) {
+        hash = std::rotl(hash ^ round(0, load64(bytes + pos)), 27) * P1 + P3;
+    }
+    for (; pos < size; pos++) {
+        hash = std::rotl(hash ^ (bytes[pos] * P3), 11) * P1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= P2;
+    hash ^= hash >> 29;
+    hash *= P3;
+    hash ^= hash >> 32;
+    return hash;
 }
 
-FString RISCV_CPU::Disassemble(const DecodedInstruction& inst) {
-    FString OpName = TEXT("UNKNOWN");
-    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+bool RISCV_CPU::HasLoadedImage() const {
+    return !Mem->LoadedImage.empty();
+}
 
-    switch (op) {
-    case OpcodeType::OP:
-        if (inst.funct7 == 0x20) OpName = TEXT("SUB");
-        else {
-            switch (inst.funct3) {
-            case 0x0: OpName = TEXT("ADD"); break;
-            case 0x1: OpName = TEXT("SLL"); break;
-            case 0x2: OpName = TEXT("SLT"); break;
-            case 0x4: OpName = TEXT("XOR"); break;
-            case 0x5: OpName = (inst.funct7 == 0x20) ? TEXT("SRA") : TEXT("SRL"); break;
-            case 0x6: OpName = TEXT("OR");  break;
-            case 0x7: OpName = TEXT("AND"); break;
-            }
+void RISCV_CPU::MarkWritten(uint32_t addr, int size) {
+    WriteCount++;
+
+    // A store can straddle two pages. The flag test is the only cost once a page is dirty.
+    uint32_t first_page = addr >> PAGE_SHIFT;
+    uint32_t last_page = (addr + size - 1) >> PAGE_SHIFT;
+    if (!std::atomic_ref<uint8_t>(DirtyPageFlags[first_page]).load(std::memory_order_relaxed)) MarkPageDirty(first_page);
+    if (!std::atomic_ref<uint8_t>(DirtyPageFlags[last_page]).load(std::memory_order_relaxed)) MarkPageDirty(last_page);
+}
+
+void RISCV_CPU::MarkPageDirty(uint32_t page) {
+    // Other harts may be dirtying the same page right now
+    std::lock_guard<std::mutex> lock(Mem->DirtyLock);
+    std::atomic_ref<uint8_t> flag(DirtyPageFlags[page]);
+    if (flag.load(std::memory_order_relaxed)) return;
+
+    flag.store(1, std::memory_order_relaxed);
+    Mem->DirtyPageList.push_back(page);
+}
+
+void RISCV_CPU::RestorePage(uint32_t page) {
+    uint32_t page_start = page << PAGE_SHIFT;
+    uint32_t page_end = page_start + PAGE_SIZE;
+
+    // Pages start out as zeros, then whatever part of the image overlaps them
+    std::fill(Memory + page_start, Memory + page_end, 0);
+
+    for (const GuestMemory::ImageSegment& seg : Mem->LoadedImage) {
+        uint32_t seg_end = seg.StartAddr + (uint32_t)seg.Bytes.size();
+        uint32_t from = std::max(page_start, seg.StartAddr);
+        uint32_t to = std::min(page_end, seg_end);
+        if (from < to) {
+            std::copy(seg.Bytes.begin() + (from - seg.StartAddr), seg.Bytes.begin() + (to - seg.StartAddr), Memory + from);
         }
-        return FString::Printf(TEXT("%s x%d, x%d, x%d"), *OpName, inst.rd, inst.rs1, inst.rs2);
+    }
+}
+
+void RISCV_CPU::RestoreImagePages() {
+    {
+        // Shared memory: the first hart to reset restores the pages every hart dirtied
+        std::lock_guard<std::mutex> lock(Mem->DirtyLock);
+        for (uint32_t page : Mem->DirtyPageList) {
+            RestorePage(page);
+            DirtyPageFlags[page] = 0;
+        }
+        Mem->DirtyPageList.clear();
+    }
+    DropPendingPages(); // Their pages were dirty, so they now hold the image again
+}
+
+void RISCV_CPU::Reset() {
+    RestoreImagePages();
+
+    for (int i = 0; i < 32; i++) {
+        Registers[i] = 0;
+    }
+    Registers[10] = HartId;
+    PC = 0;
+    ClearReservation();
+    bHalted = false;
+    CycleCount = 0;
+    StallCycle = 0;
+    SkippedCycles = 0;
+    ResetIdleDetection();
+    ResetVectorUnit();
+    ResetFloatUnit();
+    ResetPrivilegedState();
 
-    case OpcodeType::OP_IMM:
-        switch (inst.funct3) {
-        case 0x0: OpName = TEXT("ADDI"); break;
-        case 0x4: OpName = TEXT("XORI"); break;
-        case 0x6: OpName = TEXT("ORI");  break;
-        case 0x7: OpName = TEXT("ANDI"); break;
-        case 0x1: OpName = TEXT("SLLI"); break;
-        case 0x5: OpName = (inst.funct7 == 0x20) ? TEXT("SRAI") : TEXT("SRLI"); break;
+    UndoLog.Clear();
+    UndoCheckpoints.clear();
+    Bus.ResetDevices();
+    if (Scheduler) Scheduler->Reset(); // Its clock restarts at cycle 0 with ours
+}
+
+size_t RISCV_CPU::GetDirtyPageCount() const {
+    return Mem->DirtyPageList.size();
+}
+
+ArchCheckpoint RISCV_CPU::SaveCheckpoint() const {
+    ArchCheckpoint checkpoint;
+    for (int i = 0; i < 32; i++) {
+        checkpoint.Registers[i] = Registers[i];
+    }
+    checkpoint.PC = PC;
+    checkpoint.CycleCount = CycleCount;
+    std::copy(FRegs, FRegs + 32, checkpoint.FloatRegisters);
+    checkpoint.FCSR = (FRM << 5) | FFlags;
+    checkpoint.Privilege = Privilege;
+    checkpoint.Satp = Satp;
+    checkpoint.MStatus = MStatus;
+    checkpoint.MTvec = MTvec;
+    checkpoint.MEpc = MEpc;
+    checkpoint.MCause = MCause;
+    checkpoint.MTval = MTval;
+    checkpoint.MScratch = MScratch;
+    checkpoint.VL = VL;
+    checkpoint.VType = VType;
+    checkpoint.VStart = VStart;
+    checkpoint.bHalted = bHalted;
+    checkpoint.VectorRegs.assign(VectorRegs, VectorRegs + sizeof(VectorRegs));
+
+    std::lock_guard<std::mutex> lock(Mem->DirtyLock);
+    checkpoint.PageNumbers = Mem->DirtyPageList;
+    checkpoint.PageData.resize(checkpoint.PageNumbers.size() * PAGE_SIZE);
+    for (size_t i = 0; i < checkpoint.PageNumbers.size(); i++) {
+        uint32_t page = checkpoint.PageNumbers[i];
+        uint8_t* dest = checkpoint.PageData.data() + i * PAGE_SIZE;
+        if (PendingPageFlags[page]) {
+            // Not filled in RAM yet. One that cannot be (the loader said why) is saved as zeros.
+            if (!PendingPageLoader(page, dest)) std::fill(dest, dest + PAGE_SIZE, 0);
+        } else {
+            std::copy(Memory + (page << PAGE_SHIFT), Memory + ((page + 1) << PAGE_SHIFT), dest);
         }
-        return FString::Printf(TEXT("%s x%d, x%d, %d"), *OpName, inst.rd, inst.rs1, inst.imm);
+    }
+    return checkpoint;
+}
+
+void RISCV_CPU::RestoreCheckpoint(const ArchCheckpoint& checkpoint) {
+    Reset();
+    LoadCheckpointState(checkpoint);
+    if (Scheduler) Scheduler->RunUntil(CycleCount); // Nothing is pending after Reset, so this only moves the clock
+}
+
+void RISCV_CPU::LoadCheckpointState(const ArchCheckpoint& checkpoint) {
+    for (size_t i = 0; i < checkpoint.PageNumbers.size(); i++) {
+        uint32_t page = checkpoint.PageNumbers[i];
+        if (page >= NUM_PAGES) continue;
+
+        std::copy(checkpoint.PageData.begin() + i * PAGE_SIZE, checkpoint.PageData.begin() + (i + 1) * PAGE_SIZE, Memory + (page << PAGE_SHIFT));
+        MarkPageDirty(page); // Still differs from the image, so the next Reset() must restore it
+    }
+
+    for (int i = 0; i < 32; i++) {
+        Registers[i] = checkpoint.Registers[i];
+    }
+    Registers[0] = 0;
+    PC = checkpoint.PC;
+    CycleCount = checkpoint.CycleCount;
+
+    std::copy(checkpoint.FloatRegisters, checkpoint.FloatRegisters + 32, FRegs);
+    FFlags = checkpoint.FCSR & 0x1F;
+    FRM = (checkpoint.FCSR >> 5) & 0x7;
+
+    bHalted = checkpoint.bHalted;
+
+    Privilege = checkpoint.Privilege;
+    Satp = checkpoint.Satp;
+    MStatus = checkpoint.MStatus;
+    MTvec = checkpoint.MTvec;
+    MEpc = checkpoint.MEpc;
+    MCause = checkpoint.MCause;
+    MTval = checkpoint.MTval;
+    MScratch = checkpoint.MScratch;
+    bTrapPending = false;
+    FlushTLB();
+    UpdateTranslation();
+
+    VL = checkpoint.VL;
+    VType = checkpoint.VType;
+    VStart = checkpoint.VStart;
+    if (checkpoint.VectorRegs.size() == sizeof(VectorRegs)) {
+        std::copy(checkpoint.VectorRegs.begin(), checkpoint.VectorRegs.end(), VectorRegs);
+    }
+}
+
+void RISCV_CPU::ReplaceMemory(const std::vector<uint32_t>& pages, PageLoader loader, bool lazy) {
+    DropPendingPages();
+    if (Mem.use_count() > 1) lazy = false; // Other harts would read the page before it is filled
+
+    std::vector<uint8_t> listed(NUM_PAGES, 0);
+    for (uint32_t page : pages) {
+        if (page < NUM_PAGES) listed[page] = 1;
+    }
 
-    case OpcodeType::JAL:
-        return FString::Printf(TEXT("JAL x%d, %d"), inst.rd, inst.imm);
+    // Only the image and pages written since can be non-zero; clear the ones not listed
+    std::vector<uint32_t> stale;
+    {
+        std::lock_guard<std::mutex> lock(Mem->DirtyLock);
+        stale = Mem->DirtyPageList;
+    }
+    for (const GuestMemory::ImageSegment& seg : Mem->LoadedImage) {
+        if (seg.Bytes.empty()) continue;
+        uint32_t last = (seg.StartAddr + (uint32_t)seg.Bytes.size() - 1) >> PAGE_SHIFT;
+        for (uint32_t page = seg.StartAddr >> PAGE_SHIFT; page <= last; page++) {
+            stale.push_back(page);
+        }
+    }
+    for (uint32_t page : stale) {
+        if (listed[page]) continue;
+        std::fill(Memory + (page << PAGE_SHIFT), Memory + ((page + 1) << PAGE_SHIFT), 0);
+        MarkPageDirty(page);
+    }
 
-    case OpcodeType::BRANCH:
-        switch (inst.funct3) {
-        case 0x0: OpName = TEXT("BEQ"); break;
-        case 0x1: OpName = TEXT("BNE"); break;
-        case 0x4: OpName = TEXT("BLT"); break;
-        case 0x5: OpName = TEXT("BGE"); break;
+    for (uint32_t page : pages) {
+        if (page >= NUM_PAGES) continue;
+        MarkPageDirty(page); // Differs from the image, so the next Reset() must restore it
+        if (!lazy) {
+            uint8_t* dest = Memory + (page << PAGE_SHIFT);
+            if (loader(page, dest)) continue;
+            std::fill(dest, dest + PAGE_SIZE, 0); // Left pending, so the hart faults on it
         }
-        return FString::Printf(TEXT("%s x%d, x%d, %d"), *OpName, inst.rs1, inst.rs2, inst.imm);
+        if (!PendingPageFlags[page]) {
+            PendingPageFlags[page] = 1;
+            PendingPageCount++;
+        }
+    }
+    if (PendingPageCount) PendingPageLoader = std::move(loader);
 
-    case OpcodeType::LUI:   return FString::Printf(TEXT("LUI x%d, 0x%X"), inst.rd, inst.imm);
-    case OpcodeType::AUIPC: return FString::Printf(TEXT("AUIPC x%d, %d"), inst.rd, inst.imm);
+    // RAM changed underneath the hart: none of this can be rewound or reused
+    UndoLog.Clear();
+    UndoCheckpoints.clear();
+    ClearReservation();
+    ResetIdleDetection();
+    FlushTLB();
+}
 
-    default: return TEXT("UNKNOWN INST");
+bool RISCV_CPU::LoadPendingRange(uint32_t addr, uint32_t size) {
+    bool loaded = true;
+    uint32_t last = std::min((addr + size - 1) >> PAGE_SHIFT, NUM_PAGES - 1);
+    for (uint32_t page = addr >> PAGE_SHIFT; page <= last; page++) {
+        if (!PendingPageFlags[page]) continue;
+
+        // A page that fails stays pending (and zero), so every later access faults too
+        uint8_t* dest = Memory + (page << PAGE_SHIFT);
+        if (!PendingPageLoader(page, dest)) {
+            std::fill(dest, dest + PAGE_SIZE, 0);
+            loaded = false;
+            continue;
+        }
+        PendingPageFlags[page] = 0;
+        if (--PendingPageCount == 0) {
+            PendingPageLoader = nullptr; // Releases the source (e.g. unmaps the file)
+        }
     }
+    return loaded;
+}
+
+bool RISCV_CPU::LoadPendingPages() {
+    return !PendingPageCount || LoadPendingRange(0, MEMORY_SIZE);
+}
 
+void RISCV_CPU::DropPendingPages() {
+    std::fill(PendingPageFlags, PendingPageFlags + NUM_PAGES, 0);
+    PendingPageCount = 0;
+    PendingPageLoader = nullptr;
+}
+
+size_t RISCV_CPU::GetPendingPageCount() const {
+    return PendingPageCount;
+}
+
+std::shared_ptr<GuestMemory> RISCV_CPU::GetSharedMemory() {
+    return Mem;
+}
+
+uint32_t RISCV_CPU::GetPrivilege() const {
+    return Privilege;
+}
+
+bool RISCV_CPU::IsHalted() const {
+    return bHalted;
+}
+
+uint32_t RISCV_CPU::GetHartId() const {
+    return HartId;
+}
+
+FString RISCV_CPU::Disassemble(const DecodedInstruction& inst) {
+    char buffer[64];
+    RISCV_Disassembler::Disassemble(inst.raw, buffer, sizeof(buffer));
+    return FString(buffer);
 }
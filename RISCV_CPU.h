@@ -1,9 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint> // Required for uint32_t (guarantees 32-bit integers)
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include "RISCV_Bus.h"
+#include "RISCV_EventScheduler.h"
+#include "RISCV_UndoLog.h"
+
 enum class OpcodeType : uint32_t {
     LUI     = 0x37, // U-Type (Load Upper Immediate)
     AUIPC   = 0x17, // U-Type (Add Upper Immediate to PC)
@@ -14,6 +23,16 @@ enum class OpcodeType : uint32_t {
     STORE   = 0x23, // S-Type (Store to memory)
     OP_IMM  = 0x13, // I-Type (Arithmetic with Immediate, e.g., ADDI)
     OP      = 0x33, // R-Type (Register-Register ops, e.g., ADD) - No Immediate
+    AMO     = 0x2F, // R-Type (Atomics: LR/SC and AMOs, RV32A)
+    LOAD_FP = 0x07, // I-Type (FLW/FLD, and vector loads)
+    STORE_FP= 0x27, // S-Type (FSW/FSD, and vector stores)
+    OP_FP   = 0x53, // R-Type (Floating point arithmetic, RV32F/D)
+    MADD    = 0x43, // R4-Type (Fused multiply-add: rs1 * rs2 + rs3)
+    MSUB    = 0x47, // R4-Type (rs1 * rs2 - rs3)
+    NMSUB   = 0x4B, // R4-Type (-(rs1 * rs2) + rs3)
+    NMADD   = 0x4F, // R4-Type (-(rs1 * rs2) - rs3)
+    OP_V    = 0x57, // Vector arithmetic and vsetvl(i) (RVV)
+    MISC_MEM= 0x0F, // I-Type (FENCE, FENCE.I)
     SYSTEM  = 0x73  // I-Type (System calls)
 };
 
@@ -30,42 +49,421 @@ struct DecodedInstruction {
     uint32_t funct7; // Function 7: A 7-bit field for extra distinction (e.g., ADD vs SUB)
     // The reconstructed immediate value (signed 32-bit integer)
     int32_t imm;
+    uint32_t raw;    // The original 32-bit instruction word (for the disassembler)
+};
+
+/**
+ * Guest RAM plus the bookkeeping Reset() needs.
+ * Held through a shared_ptr so several harts can run on the same memory.
+ */
+struct GuestMemory {
+    struct ImageSegment {
+        uint32_t StartAddr;
+        std::vector<uint8_t> Bytes;
+        uint64_t Hash; // RISCV_CPU::HashImage of Bytes at StartAddr
+    };
+
+    std::vector<uint8_t> Bytes;
+    std::vector<uint8_t> DirtyPageFlags;
+    std::vector<uint32_t> DirtyPageList;
+    std::vector<ImageSegment> LoadedImage;
+    std::mutex DirtyLock; // Harts on other threads may dirty pages at the same time
+
+    // LR/SC (see RISCV_CPU::ExecuteAtomic). While any hart holds a reservation, every
+    // RAM store bumps the stamp of its word's bucket, so SC notices a store even when
+    // it put the reserved value back (A-B-A).
+    static constexpr uint32_t STAMP_BUCKETS = 1024;
+    std::atomic<uint32_t> ActiveReservations;
+    std::atomic<uint32_t> StoreStamps[STAMP_BUCKETS];
+
+    GuestMemory(uint32_t size, uint32_t numPages) : Bytes(size, 0), DirtyPageFlags(numPages, 0), ActiveReservations(0), StoreStamps{} {}
+};
+
+/**
+ * Lightweight architectural checkpoint: registers, PC and the pages written
+ * since the image was loaded. Everything else comes from the loaded image.
+ */
+struct ArchCheckpoint {
+    uint32_t Registers[32];
+    uint32_t PC;
+    uint64_t CycleCount;
+    uint64_t FloatRegisters[32];
+    uint32_t FCSR;
+    uint32_t Privilege;
+    uint32_t Satp;
+    uint32_t MStatus;
+    uint32_t MTvec;
+    uint32_t MEpc;
+    uint32_t MCause;
+    uint32_t MTval;
+    uint32_t MScratch;
+    uint32_t VL;
+    uint32_t VType;
+    uint32_t VStart;
+    bool bHalted; // ECALL/EBREAK with no trap handler ended the program
+    std::vector<uint8_t> VectorRegs; // 32 * VLENB bytes
+    std::vector<uint32_t> PageNumbers;
+    std::vector<uint8_t> PageData; // PageNumbers.size() * PAGE_SIZE bytes, in the same order
+};
+
+// Why the last RunFor returned early (None = it used its whole budget)
+enum class StopReason : uint8_t {
+    None,
+    Breakpoint, // About to execute a breakpoint address (not executed yet)
+    Watchpoint, // The last executed instruction accessed a watched range
+    Stalled,    // Stalled with nothing scheduled that could wake the core
+    Halted      // ECALL/EBREAK with no trap handler installed (mtvec = 0); PC is at it
+};
+
+enum class WatchType : uint8_t {
+    Read   = 1,
+    Write  = 2,
+    Access = 3 // Read or write
+};
+
+struct StopInfo {
+    StopReason Reason;
+    uint32_t PC;     // Breakpoint address, or the instruction that hit the watchpoint
+    uint32_t Addr;   // Data address of the access (watchpoints only)
+    uint32_t Size;   // Access size in bytes
+    uint32_t Value;  // Value read or written
+    bool bWrite;
+};
+
+/**
+ * Receives the physical address of every RAM access the core makes (fetches,
+ * loads, stores, page-table walks), for offline memory studies such as
+ * RISCV_CacheSweep. Device accesses are not reported. An AMO is one Store.
+ */
+class RISCV_TraceSink {
+public:
+    enum AccessKind : uint8_t { Fetch, Load, Store };
+
+    virtual ~RISCV_TraceSink() {}
+    virtual void OnAccess(uint32_t addr, uint32_t size, AccessKind kind) = 0;
 };
 
 class RISCV_CPU {
 public:
     RISCV_CPU();
+    // A hart running on memory shared with other harts (a0 holds hartId at reset).
+    // Harts of one machine also share the UART and CLINT (sized for every hart);
+    // without them the hart gets devices of its own.
+    RISCV_CPU(std::shared_ptr<GuestMemory> sharedMemory, uint32_t hartId,
+              std::shared_ptr<RISCV_UART> uart = nullptr, std::shared_ptr<RISCV_CLINT> clint = nullptr);
     ~RISCV_CPU();
 
     /**
      * Main Decoding Function.
      * Takes a raw 32-bit machine code and extracts its internal fields.
+     * Depends on nothing but the instruction word (see RISCV_PredecodeCache).
      */
-    DecodedInstruction Decode(uint32_t inst);
+    static DecodedInstruction Decode(uint32_t inst);
     void Execute(DecodedInstruction& inst);
 
     // Helper to print details to the console (for debugging purposes)
     void PrintDecodedInst(const DecodedInstruction& dec);
 
     // Memory size
-    static const uint32_t MEMORY_SIZE = 1024 * 1024;
+    static constexpr uint32_t MEMORY_SIZE = 1024 * 1024;
+
+    // Memory is tracked in pages for dirty tracking (4 KiB, same as Sv32)
+    static constexpr uint32_t PAGE_SHIFT = 12;
+    static constexpr uint32_t PAGE_SIZE  = 1 << PAGE_SHIFT;
+    static constexpr uint32_t NUM_PAGES  = MEMORY_SIZE >> PAGE_SHIFT;
 
+    // Copies a program into RAM and remembers it as part of the image Reset() restores
     void LoadMemory(const std::vector<uint8_t>& programData, uint32_t startAddr);
+    bool HasLoadedImage() const;
+
+    // 64-bit content hash of an image and its load address (not cryptographic). Fast
+    // enough to run on every LoadMemory, so a segment's hash is always at hand.
+    static uint64_t HashImage(const uint8_t* bytes, size_t size, uint32_t startAddr);
+
+    // Back to the state right after LoadMemory, in place: clears registers, PC and
+    // devices, and rewrites only the pages the guest has written since then.
+    void Reset();
+    size_t GetDirtyPageCount() const;
+
+    std::shared_ptr<GuestMemory> GetSharedMemory();
+    uint32_t GetHartId() const;
+
+    // Checkpoints hold only what differs from the loaded image (registers, PC, dirty pages).
+    // Restoring resets to the image first, so it must be the same image that was saved against.
+    ArchCheckpoint SaveCheckpoint() const;
+    void RestoreCheckpoint(const ArchCheckpoint& checkpoint);
+
+    // Replaces all of RAM with the listed pages (zero everywhere else), for restoring a
+    // self-contained snapshot such as RISCV_CheckpointFile. 'loader' fills one page.
+    // With 'lazy', a page is only filled when the hart first touches it, so a large
+    // snapshot resumes without decoding pages it never uses. The pages count as written,
+    // so Reset() goes back to the image and drops those still pending. Memory shared
+    // with other harts is always filled up front (their accesses are not checked).
+    // A page the loader cannot fill (it returns false) stays pending and zero, and every
+    // access to it raises an access fault instead of running on made-up contents.
+    using PageLoader = std::function<bool(uint32_t page, uint8_t* dest)>;
+    void ReplaceMemory(const std::vector<uint32_t>& pages, PageLoader loader, bool lazy);
+    bool LoadPendingPages(); // Fills every pending page, e.g. before reading GetSharedMemory() directly
+    size_t GetPendingPageCount() const;
     uint32_t GetRegisterValue(int reg_index) const;
+    void SetRegisterValue(int reg_index, uint32_t value);
     uint32_t GetPC() const;
+    void SetPC(uint32_t pc);
     uint32_t FetchInstruction();
     FString Disassemble(const DecodedInstruction& inst);
+
+    // Vector unit (RVV subset, see RISCV_CPU_Vector.cpp). One vector register is one
+    // 512-bit AVX-512 register, or two AVX2 / four SSE registers.
+    static constexpr uint32_t VLEN  = 512;
+    static constexpr uint32_t VLENB = VLEN / 8;
+    const uint8_t* GetVectorRegister(int reg_index) const;
+    uint32_t GetVL() const;
+
+    // Privilege mode (PRIV_M after reset). Virtual memory (Sv32) is active
+    // in S and U mode once satp selects it.
+    static constexpr uint32_t PRIV_U = 0;
+    static constexpr uint32_t PRIV_S = 1;
+    static constexpr uint32_t PRIV_M = 3;
+    uint32_t GetPrivilege() const;
+
+    // Bare-metal programs with no trap handler (mtvec = 0) end with ECALL or EBREAK:
+    // the hart halts there and RunFor stops with StopReason::Halted until Reset.
+    bool IsHalted() const;
+
+    // Floating point unit (RV32F/D, see RISCV_CPU_Float.cpp). Raw register bits:
+    // single-precision values are NaN-boxed (upper 32 bits all ones).
+    uint64_t GetFloatRegister(int reg_index) const;
+    void SetFloatRegister(int reg_index, uint64_t bits);
     
     // Debug helper
     void DebugDump();
 
+    // Memory-mapped devices (everything above MEMORY_SIZE)
+    RISCV_Bus& GetBus();
+    RISCV_UART& GetUART();
+    RISCV_CLINT& GetCLINT();
+    uint64_t GetCycleCount() const;
+
+    // Fetch/Decode/Execute loop. Returns the number of instructions executed.
+    uint64_t RunFor(uint64_t maxInstructions);
+
+    // Predecoded execution (see RISCV_PredecodeCache). RunFor takes the instructions in
+    // [base, base + 4 * count) from 'entries' instead of fetching and decoding them, as
+    // long as their page still holds the loaded image (not written since the last Reset)
+    // and translation is off. 'entries' must outlive the attachment; nullptr detaches,
+    // and so does LoadMemory.
+    void AttachPredecoded(const DecodedInstruction* entries, uint32_t base, uint32_t count);
+
+    // Discrete-event kernel (optional, not owned). RunFor fires its events as the
+    // cycle count reaches them, so attached models can ScheduleAt() future cycles.
+    // RunFor leaves the scheduler's clock at the cycle count, so ScheduleIn() between
+    // runs counts from where the core stopped. Reset() drops every pending event.
+    void AttachScheduler(RISCV_EventScheduler* scheduler);
+    RISCV_EventScheduler* GetScheduler();
+
+    // Block the core until 'cycle' (UINT64_MAX = until an event calls StallUntil again).
+    // While stalled, RunFor jumps from event to event instead of counting cycles.
+    void StallUntil(uint64_t cycle);
+
+    // Idle-loop fast-forward (on by default). When a loop iteration ends with exactly
+    // the registers it started with and wrote no memory, every further iteration would
+    // be identical, so RunFor skips whole iterations up to the next scheduler event,
+    // CLINT deadline or the end of its budget, counting their cycles and instructions.
+    void EnableIdleSkip(bool enable);
+    uint64_t GetSkippedCycles() const;
+
+    // Breakpoints and watchpoints. Each page has a flag byte saying whether anything
+    // on it is watched, so fetches and accesses elsewhere only pay one flag test;
+    // the precise lists are searched on flagged pages only. A hit ends RunFor and
+    // GetStopInfo() says where. Breakpoints at the PC RunFor starts from are stepped over.
+    void AddBreakpoint(uint32_t pc);
+    bool RemoveBreakpoint(uint32_t pc);
+    void AddWatchpoint(uint32_t addr, uint32_t size, WatchType type);
+    bool RemoveWatchpoint(uint32_t addr, uint32_t size);
+    void ClearBreakpoints(); // Removes watchpoints too
+    const StopInfo& GetStopInfo() const;
+
+    // Memory access trace (nullptr = off, which costs one pointer test per access).
+    // Idle-loop skipping is suspended while a sink is attached, so no access is lost.
+    void SetTraceSink(RISCV_TraceSink* sink);
+
+    // Reverse execution. While enabled, every Execute records an UndoRecord and
+    // idle-loop skipping is suspended. Stepping back through the recorded window
+    // costs time proportional to how far we rewind; history older than that is
+    // reached by restoring a checkpoint and replaying forward to the target (the
+    // replay repeats device accesses, it does not rewind them).
+    void EnableUndoLog(bool enable, size_t maxChunks = RISCV_UndoLog::DEFAULT_MAX_CHUNKS);
+    uint64_t StepBack(uint64_t count);           // Returns how many instructions were undone
+    bool RunBackwardUntil(uint32_t targetPC);    // Stops once PC == targetPC (false if history ran out)
+    uint64_t GetUndoDepth() const;               // How many instructions StepBack can undo
+
 private:
 
     // Helper function to reconstruct the immediate value
-    int32_t GenerateImmediate(uint32_t inst, uint32_t opcode);
+    static int32_t GenerateImmediate(uint32_t inst, uint32_t opcode);
     // --- State Elements ---
     uint32_t Registers[32]; // x0-x31 general purpose registers
     uint32_t PC;            // Program Counter
+    uint64_t CycleCount;    // Cycles elapsed: one per instruction, plus any stall time
+    uint64_t StallCycle;    // Core does not execute before this cycle
+    RISCV_EventScheduler* Scheduler;
+
+    RISCV_TraceSink* TraceSink;
+
+    // --- Idle Loop Detection ---
+    // A snapshot is taken at one backward jump and compared at the next one.
+    // After a mismatch we back off (exponentially) so busy loops do not pay for the copy.
+    bool bIdleSkipEnabled;
+    bool bIdleSnapshotValid;
+    uint32_t IdleLoopHead;
+    uint32_t IdleRegisters[32];
+    uint64_t IdleWriteCount;
+    uint64_t IdleSnapshotCycle;
+    uint32_t IdleBackoff;       // Backward jumps to ignore before the next snapshot
+    uint32_t IdleBackoffLength;
+    uint64_t WriteCount;        // Memory/device writes so far
+    uint64_t SkippedCycles;
+    uint64_t SkipIdleLoop(uint64_t budget);
+    void ResetIdleDetection();
+
+    // --- Breakpoints & Watchpoints ---
+    // Page flags index with a mask: RAM is a power of two, so addresses outside it
+    // alias onto some RAM page and at worst cost a precise check that rejects them.
+    static constexpr uint8_t WATCH_EXEC  = 0x1;
+    static constexpr uint8_t WATCH_READ  = 0x2;
+    static constexpr uint8_t WATCH_WRITE = 0x4;
+    static constexpr uint32_t WATCH_PAGE_MASK = NUM_PAGES - 1;
+    static_assert((NUM_PAGES & WATCH_PAGE_MASK) == 0, "MEMORY_SIZE must be a power of two");
+
+    struct Watchpoint {
+        uint32_t Addr;
+        uint32_t Size;
+        WatchType Type;
+    };
+    uint8_t WatchPageFlags[NUM_PAGES];
+    std::vector<uint32_t> Breakpoints;
+    std::vector<Watchpoint> Watchpoints;
+    StopInfo Stop;
+    bool bStopRequested;
+    bool bHalted;
+    void RebuildWatchFlags();
+    void FlagWatchRange(uint32_t addr, uint32_t size, uint8_t flag);
+    void CheckWatchpoints(uint32_t addr, uint32_t size, uint32_t value, bool isWrite);
+
+    // --- Control and Status Registers (Zicsr) ---
+    static constexpr uint32_t CSR_FFLAGS  = 0x001;
+    static constexpr uint32_t CSR_FRM     = 0x002;
+    static constexpr uint32_t CSR_FCSR    = 0x003;
+    static constexpr uint32_t CSR_VSTART  = 0x008;
+    static constexpr uint32_t CSR_SATP    = 0x180;
+    static constexpr uint32_t CSR_MSTATUS = 0x300;
+    static constexpr uint32_t CSR_MTVEC   = 0x305;
+    static constexpr uint32_t CSR_MSCRATCH= 0x340;
+    static constexpr uint32_t CSR_MEPC    = 0x341;
+    static constexpr uint32_t CSR_MCAUSE  = 0x342;
+    static constexpr uint32_t CSR_MTVAL   = 0x343;
+    static constexpr uint32_t CSR_CYCLE   = 0xC00;
+    static constexpr uint32_t CSR_TIME    = 0xC01;
+    static constexpr uint32_t CSR_VL      = 0xC20;
+    static constexpr uint32_t CSR_VTYPE   = 0xC21;
+    static constexpr uint32_t CSR_VLENB   = 0xC22;
+    static constexpr uint32_t CSR_CYCLEH  = 0xC80;
+    static constexpr uint32_t CSR_TIMEH   = 0xC81;
+    static constexpr uint32_t CSR_MHARTID = 0xF14;
+    uint32_t ExecuteCSR(const DecodedInstruction& inst, bool writeCSR);
+    bool ReadCSR(uint32_t csr, uint32_t& value);
+    bool WriteCSR(uint32_t csr, uint32_t value);
+
+    // --- Traps (machine mode only, no delegation or interrupts) ---
+    // An instruction that faults raises a pending trap; Execute then skips its
+    // write-back and enters the handler at mtvec instead of the next PC.
+    static constexpr uint32_t CAUSE_FETCH_ACCESS_FAULT  = 1;
+    static constexpr uint32_t CAUSE_ILLEGAL_INSTRUCTION = 2;
+    static constexpr uint32_t CAUSE_BREAKPOINT          = 3;
+    static constexpr uint32_t CAUSE_LOAD_MISALIGNED     = 4;
+    static constexpr uint32_t CAUSE_LOAD_ACCESS_FAULT   = 5;
+    static constexpr uint32_t CAUSE_STORE_MISALIGNED    = 6; // Store or AMO
+    static constexpr uint32_t CAUSE_STORE_ACCESS_FAULT  = 7;
+    static constexpr uint32_t CAUSE_ECALL_FROM_U        = 8; // + privilege (S = 9, M = 11)
+    static constexpr uint32_t CAUSE_FETCH_PAGE_FAULT    = 12;
+    static constexpr uint32_t CAUSE_LOAD_PAGE_FAULT     = 13;
+    static constexpr uint32_t CAUSE_STORE_PAGE_FAULT    = 15;
+    static constexpr uint32_t MSTATUS_MIE  = 1u << 3;
+    static constexpr uint32_t MSTATUS_MPIE = 1u << 7;
+    static constexpr uint32_t MSTATUS_MPP  = 3u << 11;
+    static constexpr uint32_t MSTATUS_SUM  = 1u << 18; // S mode may access U pages
+    static constexpr uint32_t MSTATUS_MXR  = 1u << 19; // Loads from execute-only pages
+    static constexpr uint32_t MSTATUS_MASK = MSTATUS_MIE | MSTATUS_MPIE | MSTATUS_MPP | MSTATUS_SUM | MSTATUS_MXR;
+    uint32_t Privilege;
+    uint32_t MStatus;
+    uint32_t MTvec;
+    uint32_t MEpc;
+    uint32_t MCause;
+    uint32_t MTval;
+    uint32_t MScratch;
+    bool bTrapPending;
+    uint32_t PendingCause;
+    uint32_t PendingTval;
+    void RaiseTrap(uint32_t cause, uint32_t tval); // The first trap of an instruction wins
+    void TakeTrap();
+    void ReturnFromTrap(); // MRET
+    void ResetPrivilegedState();
+
+    // --- Virtual Memory (Sv32) ---
+    // A direct-mapped software TLB keeps one tag per access type, holding the VPN
+    // only if that access is allowed (permissions, privilege, SUM/MXR and the D bit
+    // for stores already checked). A hit is therefore one compare; everything else
+    // goes to the page-table walk.
+    enum AccessType : uint32_t { ACCESS_LOAD = 0, ACCESS_STORE = 1, ACCESS_FETCH = 2 };
+    struct TLBEntry {
+        uint32_t Tag[3];   // Per AccessType: VPN, or TLB_INVALID
+        uint32_t PhysPage; // Physical address of the 4 KiB page
+    };
+    static constexpr uint32_t TLB_ENTRIES = 256;
+    static constexpr uint32_t TLB_INVALID = 0xFFFFFFFF; // Never a VPN (those are 20 bits)
+    TLBEntry TLB[TLB_ENTRIES];
+    bool bTLBHasSuperpages; // A 4 MiB page may sit in many entries, so sfence.vma on one address must flush all
+    bool bTranslate;        // satp.MODE = Sv32 and not in M mode
+    uint32_t Satp;
+
+    bool Translate(uint32_t& addr, AccessType type) {
+        uint32_t vpn = addr >> PAGE_SHIFT;
+        const TLBEntry& entry = TLB[vpn & (TLB_ENTRIES - 1)];
+        if (entry.Tag[type] == vpn) {
+            addr = entry.PhysPage | (addr & (PAGE_SIZE - 1));
+            return true;
+        }
+        return WalkPageTable(addr, type);
+    }
+    bool WalkPageTable(uint32_t& addr, AccessType type); // Fills the TLB; raises a page fault on failure
+    void FlushTLB();
+    void FlushTLBAddress(uint32_t vaddr);
+    void UpdateTranslation();
+
+    // --- Floating Point Unit (RV32F/D) ---
+    // Arithmetic runs on the host FPU in the guest's rounding mode; host exception
+    // flags are collected after each operation into FFlags.
+    uint64_t FRegs[32];
+    uint32_t FFlags; // NV DZ OF UF NX (sticky)
+    uint32_t FRM;    // Dynamic rounding mode
+    bool ExecuteFloat(const DecodedInstruction& inst, uint32_t& scalarResult); // true if x[rd] is written
+    template <typename F> bool ExecuteFloatOp(const DecodedInstruction& inst, uint32_t& scalarResult);
+    template <typename F> void ExecuteFusedMultiplyAdd(const DecodedInstruction& inst);
+    void ResetFloatUnit();
+
+    // --- Vector Unit (RVV subset: SEW 8/16/32, LMUL 1-8) ---
+    // Registers are contiguous so a register group (LMUL > 1) is one flat array,
+    // and the element loops in RISCV_CPU_Vector.cpp compile to host SIMD.
+    static constexpr uint32_t VTYPE_VILL = 0x80000000;
+    alignas(64) uint8_t VectorRegs[32 * VLENB];
+    uint32_t VL;
+    uint32_t VType;
+    uint32_t VStart;
+    bool ExecuteVector(const DecodedInstruction& inst, uint32_t& scalarResult); // true if rd is written
+    uint32_t SetVectorConfig(uint32_t avl, uint32_t vtype, bool keepVL);
+    void ExecuteVectorMemory(const DecodedInstruction& inst, bool isStore);
+    bool ExecuteVectorArith(const DecodedInstruction& inst, uint32_t& scalarResult);
+    void ResetVectorUnit();
 
     // --- Bitmasks & Shift Constants ---
     // These constants map to the RISC-V 32-bit instruction format.
@@ -81,9 +479,128 @@ private:
     static const int RS2_SHIFT     = 20;
     static const int FUNCT7_SHIFT  = 25;
 
-    // The Physical Memory (RAM)
-    std::vector<uint8_t> Memory;
+    // The Physical Memory (RAM), possibly shared with other harts
+    std::shared_ptr<GuestMemory> Mem;
+    uint8_t* Memory;         // == Mem->Bytes.data(), cached for the hot path
+    uint8_t* DirtyPageFlags; // == Mem->DirtyPageFlags.data()
+    uint32_t HartId;
+
+    // Predecoded image (see AttachPredecoded)
+    const DecodedInstruction* Predecoded;
+    uint32_t PredecodedBase;
+    uint32_t PredecodedCount;
+
+    const DecodedInstruction* LookupPredecoded(uint32_t pc) const {
+        uint32_t offset = pc - PredecodedBase; // Wraps around (and misses) below the base
+        if ((offset >> 2) >= PredecodedCount || (offset & 0x3) || bTranslate || TraceSink) return nullptr;
+        if (std::atomic_ref<uint8_t>(DirtyPageFlags[pc >> PAGE_SHIFT]).load(std::memory_order_relaxed)) return nullptr;
+        return &Predecoded[offset >> 2];
+    }
     uint32_t MemRead(uint32_t addr, int size, bool signed_extend);
     void MemWrite(uint32_t addr, uint32_t data, int size);
+    void MemWritePhysical(uint32_t addr, uint32_t data, int size);
+
+    // Raw RAM access (little endian, like every host we build for). Other harts may
+    // store to or run AMOs on the same bytes, so everything goes through relaxed
+    // atomics, and a naturally aligned halfword or word is a single access that never
+    // tears. On the hosts we build for these are ordinary loads and stores.
+    uint32_t LoadRAM(uint32_t addr, int size) const {
+        uint8_t* bytes = Memory + addr;
+        if (size == 4 && !(addr & 0x3)) return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(bytes)).load(std::memory_order_relaxed);
+        if (size == 2 && !(addr & 0x1)) return std::atomic_ref<uint16_t>(*reinterpret_cast<uint16_t*>(bytes)).load(std::memory_order_relaxed);
+        uint32_t value = 0;
+        for (int i = 0; i < size; i++) {
+            value |= (uint32_t)std::atomic_ref<uint8_t>(bytes[i]).load(std::memory_order_relaxed) << (i * 8);
+        }
+        return value;
+    }
+    void StoreRAM(uint32_t addr, uint32_t data, int size) {
+        uint8_t* bytes = Memory + addr;
+        if (size == 4 && !(addr & 0x3)) {
+            std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(bytes)).store(data, std::memory_order_relaxed);
+        } else if (size == 2 && !(addr & 0x1)) {
+            std::atomic_ref<uint16_t>(*reinterpret_cast<uint16_t*>(bytes)).store((uint16_t)data, std::memory_order_relaxed);
+        } else {
+            for (int i = 0; i < size; i++) {
+                std::atomic_ref<uint8_t>(bytes[i]).store((uint8_t)(data >> (i * 8)), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // --- Dirty Page Tracking ---
+    // Every page written since load is flagged once and remembered in a list,
+    // so Reset() costs O(pages touched) instead of O(MEMORY_SIZE).
+    void MarkWritten(uint32_t addr, int size);
+    void MarkPageDirty(uint32_t page);
+    void RestorePage(uint32_t page);
+    void RestoreImagePages(); // Every dirty page goes back to the loaded image
+    void LoadCheckpointState(const ArchCheckpoint& checkpoint); // Onto image-only RAM
+
+    // --- Pending Pages (see ReplaceMemory) ---
+    // Every path that touches RAM directly calls LoadIfPending first and faults if it
+    // fails; with nothing pending that is a single test, like bTranslate.
+    uint8_t PendingPageFlags[NUM_PAGES];
+    uint32_t PendingPageCount;
+    PageLoader PendingPageLoader;
+
+    bool LoadIfPending(uint32_t addr, uint32_t size) {
+        return !PendingPageCount || LoadPendingRange(addr, size);
+    }
+    bool LoadPendingRange(uint32_t addr, uint32_t size);
+    void DropPendingPages();
+
+    // --- Atomics (RV32A) ---
+    // LR/SC keeps the reserved value and the word's store stamp (see GuestMemory).
+    // SC succeeds if the stamp is unchanged and a host compare-and-swap still finds the value.
+    bool bReservationValid;
+    uint32_t ReservationAddr;
+    uint32_t ReservationValue;
+    uint32_t ReservationStamp;
+    void ClearReservation();
+
+    // Every RAM store calls this; with no reservation held anywhere it is a single test
+    void NoteStore(uint32_t addr, uint32_t size) {
+        if (Mem->ActiveReservations.load(std::memory_order_relaxed)) BumpStoreStamps(addr, size);
+    }
+    void BumpStoreStamps(uint32_t addr, uint32_t size);
+    uint32_t ExecuteAtomic(const DecodedInstruction& inst, uint32_t addr, uint32_t src, UndoRecord* undo);
+
+    // The Device Bus (UART, CLINT) - only consulted for addresses outside RAM
+    RISCV_Bus Bus;
+    std::shared_ptr<RISCV_UART> Uart;
+    std::shared_ptr<RISCV_CLINT> Clint;
+
+    // Reverse Execution History
+    bool bUndoEnabled;
+    RISCV_UndoLog UndoLog;
+    std::vector<uint8_t> UndoExtra; // Scratch for the extra state of a popped record
+    void RecordStoreUndo(UndoRecord& undo, uint32_t addr, int size);
+    void ApplyUndo(const UndoRecord& undo, const std::vector<uint8_t>& extra);
+
+    // Extra undo state: a kind byte, then its payload. An instruction may save several.
+    enum UndoExtraKind : uint8_t {
+        UNDO_FREG = 1, // Register, FFlags (u8 each), old value (u64)
+        UNDO_VREGS,    // First register, count (u8 each), then count * VLENB bytes
+        UNDO_VCONFIG,  // VL, VType, VStart (u32 each)
+        UNDO_MEMORY,   // Physical address (u32), size (u16), then the overwritten bytes
+        UNDO_CONTROL,  // Privilege, CSRs and FP/vector CSRs (UndoControlState)
+    };
+    bool bUndoStores; // While set, RAM stores save the bytes they overwrite (FP and vector stores)
+    void RecordFloatUndo(uint32_t reg);
+    void RecordVectorUndo(const DecodedInstruction& inst);
+    void RecordMemoryUndo(uint32_t addr, uint32_t size);
+    void RecordControlUndo();
+    void ApplyExtraUndo(const std::vector<uint8_t>& extra);
+
+    // A full checkpoint at the start of every undo chunk, kept after the chunk's records are
+    // dropped so older history can still be reached by restoring one and replaying forward
+    struct UndoCheckpoint {
+        uint64_t Index; // Undo record index (instructions since the history started)
+        ArchCheckpoint State;
+    };
+    std::deque<UndoCheckpoint> UndoCheckpoints;
+    void SaveUndoCheckpoint();
+    void RewindTo(uint64_t index);
+    void ReplayStep();
 
 };
@@ -0,0 +1,402 @@
+#include "RISCV_CPU.h"
+#include <cfenv>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+// Floating point unit (RV32F/D) of RISCV_CPU.
+//
+// Arithmetic, square root, FMA and int<->float conversions run as single host
+// FPU instructions (SSE/AVX on x86). Around each of them the host rounding mode
+// is switched only if the guest asks for something other than round-to-nearest,
+// and the host exception flags are read back into fflags. The parts where IEEE
+// leaves room and RISC-V does not are done by hand: canonical NaN results,
+// fmin/fmax on NaNs and signed zeros, saturating float->int conversions,
+// compare flags and fclass.
+//
+// Limits: RMM (round to nearest, ties to max magnitude) has no host equivalent
+// and rounds to nearest-even for arithmetic (conversions to integer do honour it).
+// The host must not be running with flush-to-zero / denormals-are-zero enabled.
+
+// This file changes the rounding mode and reads exception flags. GCC has no
+// FENV_ACCESS pragma: only -frounding-math stops it from folding or moving FP
+// operations across fesetround and fetestexcept.
+#if defined(_MSC_VER)
+#pragma fenv_access (on)
+#elif defined(__clang__)
+#pragma STDC FENV_ACCESS ON
+#elif defined(__GNUC__) && !defined(__ROUNDING_MATH__)
+#error "RISCV_CPU_Float.cpp must be compiled with -frounding-math on GCC"
+#endif
+
+namespace {
+
+constexpr uint64_t NAN_BOX = 0xFFFFFFFF00000000ull;
+
+// fflags bits
+constexpr uint32_t FLAG_NX = 0x01; // Inexact
+constexpr uint32_t FLAG_UF = 0x02; // Underflow
+constexpr uint32_t FLAG_OF = 0x04; // Overflow
+constexpr uint32_t FLAG_DZ = 0x08; // Divide by zero
+constexpr uint32_t FLAG_NV = 0x10; // Invalid
+
+// Rounding modes (rm field / frm)
+constexpr uint32_t RM_RNE = 0;
+constexpr uint32_t RM_RTZ = 1;
+constexpr uint32_t RM_RDN = 2;
+constexpr uint32_t RM_RUP = 3;
+constexpr uint32_t RM_RMM = 4;
+constexpr uint32_t RM_DYN = 7;
+
+// FSGNJ, FMIN/FMAX, compares, FCLASS and the moves use funct3 as a sub-opcode, not rm
+bool UsesRoundingMode(OpcodeType op, uint32_t funct5) {
+    if (op != OpcodeType::OP_FP) return true; // The fused multiply-adds
+    return funct5 != 0x04 && funct5 != 0x05 && funct5 != 0x14 && funct5 != 0x1C && funct5 != 0x1E;
+}
+
+template <typename F> struct FloatFormat;
+
+template <> struct FloatFormat<float> {
+    using Bits = uint32_t;
+    static constexpr Bits SIGN = 0x80000000u;
+    static constexpr Bits EXPONENT = 0x7F800000u;
+    static constexpr Bits FRACTION = 0x007FFFFFu;
+    static constexpr Bits QUIET = 0x00400000u;
+    static constexpr Bits CANONICAL_NAN = 0x7FC00000u;
+};
+
+template <> struct FloatFormat<double> {
+    using Bits = uint64_t;
+    static constexpr Bits SIGN = 0x8000000000000000ull;
+    static constexpr Bits EXPONENT = 0x7FF0000000000000ull;
+    static constexpr Bits FRACTION = 0x000FFFFFFFFFFFFFull;
+    static constexpr Bits QUIET = 0x0008000000000000ull;
+    static constexpr Bits CANONICAL_NAN = 0x7FF8000000000000ull;
+};
+
+template <typename F>
+typename FloatFormat<F>::Bits ToBits(F value) {
+    typename FloatFormat<F>::Bits bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+template <typename F>
+F FromBits(typename FloatFormat<F>::Bits bits) {
+    F value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Register -> raw bits. A single that is not properly NaN-boxed reads as the canonical NaN.
+template <typename F>
+typename FloatFormat<F>::Bits UnboxBits(uint64_t reg) {
+    if constexpr (std::is_same_v<F, float>) {
+        return ((reg & NAN_BOX) == NAN_BOX) ? (uint32_t)reg : FloatFormat<float>::CANONICAL_NAN;
+    } else {
+        return reg;
+    }
+}
+
+template <typename F>
+uint64_t BoxBits(typename FloatFormat<F>::Bits bits) {
+    if constexpr (std::is_same_v<F, float>) {
+        return NAN_BOX | bits;
+    } else {
+        return bits;
+    }
+}
+
+// Results of arithmetic: any NaN becomes the canonical NaN (the host would keep a payload)
+template <typename F>
+uint64_t BoxResult(F value) {
+    return BoxBits<F>(std::isnan(value) ? FloatFormat<F>::CANONICAL_NAN : ToBits(value));
+}
+
+template <typename F>
+bool IsSignalingNaN(typename FloatFormat<F>::Bits bits) {
+    using Fmt = FloatFormat<F>;
+    return (bits & Fmt::EXPONENT) == Fmt::EXPONENT && (bits & Fmt::FRACTION) != 0 && !(bits & Fmt::QUIET);
+}
+
+/**
+ * Runs one host FP operation in the guest's rounding mode and collects the
+ * host exception flags it raised into fflags.
+ */
+class HostFloatScope {
+public:
+    HostFloatScope(uint32_t rm, uint32_t& flags) : Flags(flags) {
+        HostMode = FE_TONEAREST;
+        if (rm == RM_RTZ) HostMode = FE_TOWARDZERO;
+        if (rm == RM_RDN) HostMode = FE_DOWNWARD;
+        if (rm == RM_RUP) HostMode = FE_UPWARD;
+
+        if (HostMode != FE_TONEAREST) std::fesetround(HostMode);
+        std::feclearexcept(FE_ALL_EXCEPT);
+    }
+
+    ~HostFloatScope() {
+        int raised = std::fetestexcept(FE_ALL_EXCEPT);
+        if (raised & FE_INEXACT)   Flags |= FLAG_NX;
+        if (raised & FE_UNDERFLOW) Flags |= FLAG_UF;
+        if (raised & FE_OVERFLOW)  Flags |= FLAG_OF;
+        if (raised & FE_DIVBYZERO) Flags |= FLAG_DZ;
+        if (raised & FE_INVALID)   Flags |= FLAG_NV;
+        if (HostMode != FE_TONEAREST) std::fesetround(FE_TONEAREST);
+    }
+
+private:
+    uint32_t& Flags;
+    int HostMode;
+};
+
+// Rounds to an integral value in the given mode (RMM included), without touching flags
+template <typename F>
+F RoundIntegral(F value, uint32_t rm) {
+    switch (rm) {
+        case RM_RTZ: return std::trunc(value);
+        case RM_RDN: return std::floor(value);
+        case RM_RUP: return std::ceil(value);
+        case RM_RMM: return std::round(value);
+        default:     return std::nearbyint(value); // Host default mode is round-to-nearest-even
+    }
+}
+
+// FCVT.W/WU: saturate out-of-range and NaN inputs, as the spec requires (x86 would return 0x80000000)
+template <typename F>
+uint32_t ConvertToInt(F value, uint32_t rm, bool isUnsigned, uint32_t& flags) {
+    if (std::isnan(value)) {
+        flags |= FLAG_NV;
+        return isUnsigned ? 0xFFFFFFFFu : 0x7FFFFFFFu;
+    }
+
+    double rounded = (double)RoundIntegral(value, rm); // Exact: every float/double integer fits in a double
+    double low = isUnsigned ? 0.0 : -2147483648.0;
+    double high = isUnsigned ? 4294967296.0 : 2147483648.0;
+    if (rounded < low || rounded >= high) {
+        flags |= FLAG_NV;
+        if (isUnsigned) return (rounded < low) ? 0u : 0xFFFFFFFFu;
+        return (rounded < low) ? 0x80000000u : 0x7FFFFFFFu;
+    }
+
+    if (rounded != (double)value) flags |= FLAG_NX;
+    return isUnsigned ? (uint32_t)rounded : (uint32_t)(int32_t)rounded;
+}
+
+template <typename F>
+uint32_t Classify(typename FloatFormat<F>::Bits bits) {
+    using Fmt = FloatFormat<F>;
+    bool negative = (bits & Fmt::SIGN) != 0;
+    typename Fmt::Bits exponent = bits & Fmt::EXPONENT;
+    typename Fmt::Bits fraction = bits & Fmt::FRACTION;
+
+    if (exponent == Fmt::EXPONENT) {
+        if (fraction == 0) return negative ? (1u << 0) : (1u << 7); // -inf / +inf
+        return (bits & Fmt::QUIET) ? (1u << 9) : (1u << 8);        // qNaN / sNaN
+    }
+    if (exponent == 0) {
+        if (fraction == 0) return negative ? (1u << 3) : (1u << 4); // -0 / +0
+        return negative ? (1u << 2) : (1u << 5);                    // Subnormal
+    }
+    return negative ? (1u << 1) : (1u << 6);                        // Normal
+}
+
+} // namespace
+
+void RISCV_CPU::ResetFloatUnit() {
+    for (int i = 0; i < 32; i++) {
+        FRegs[i] = 0;
+    }
+    FFlags = 0;
+    FRM = RM_RNE;
+}
+
+uint64_t RISCV_CPU::GetFloatRegister(int reg_index) const {
+    if (reg_index < 0 || reg_index > 31) return 0;
+    return FRegs[reg_index];
+}
+
+void RISCV_CPU::SetFloatRegister(int reg_index, uint64_t bits) {
+    if (reg_index < 0 || reg_index > 31) return;
+    FRegs[reg_index] = bits;
+}
+
+bool RISCV_CPU::ExecuteFloat(const DecodedInstruction& inst, uint32_t& scalarResult) {
+    // FP registers are invisible to idle-loop detection, so count FP instructions as writes
+    WriteCount++;
+
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+    uint32_t fmt = (inst.raw >> 25) & 0x3; // 0 = S, 1 = D (OP-FP and R4 forms)
+
+    // rm 5 and 6 are reserved, and so is DYN while frm holds 5, 6 or 7
+    if (op != OpcodeType::LOAD_FP && op != OpcodeType::STORE_FP && UsesRoundingMode(op, inst.funct7 >> 2)) {
+        uint32_t rm = (inst.funct3 == RM_DYN) ? FRM : inst.funct3;
+        if (rm > RM_RMM) {
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+            return false;
+        }
+    }
+
+    switch (op) {
+        case OpcodeType::LOAD_FP: {
+            uint32_t addr = Registers[inst.rs1] + inst.imm;
+            uint64_t value = MemRead(addr, 4, false);       // FLW
+            if (inst.funct3 == 0x3) {                        // FLD
+                value |= (uint64_t)MemRead(addr + 4, 4, false) << 32;
+            } else {
+                value |= NAN_BOX;
+            }
+            if (!bTrapPending) FRegs[inst.rd] = value; // A faulting load leaves the register alone
+            return false;
+        }
+
+        case OpcodeType::STORE_FP: {
+            uint32_t addr = Registers[inst.rs1] + inst.imm;
+            MemWrite(addr, (uint32_t)FRegs[inst.rs2], 4); // FSW (and the low half of FSD)
+            if (inst.funct3 == 0x3 && !bTrapPending) {
+                MemWrite(addr + 4, (uint32_t)(FRegs[inst.rs2] >> 32), 4);
+            }
+            return false;
+        }
+
+        case OpcodeType::MADD:
+        case OpcodeType::MSUB:
+        case OpcodeType::NMSUB:
+        case OpcodeType::NMADD:
+            if (fmt == 0) ExecuteFusedMultiplyAdd<float>(inst);
+            else if (fmt == 1) ExecuteFusedMultiplyAdd<double>(inst);
+            else RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw); // Half and quad precision
+            return false;
+
+        case OpcodeType::OP_FP:
+            if (fmt == 0) return ExecuteFloatOp<float>(inst, scalarResult);
+            if (fmt == 1) return ExecuteFloatOp<double>(inst, scalarResult);
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+template <typename F>
+void RISCV_CPU::ExecuteFusedMultiplyAdd(const DecodedInstruction& inst) {
+    uint32_t rs3 = inst.raw >> 27;
+    uint32_t rm = (inst.funct3 == RM_DYN) ? FRM : inst.funct3;
+
+    F a = FromBits<F>(UnboxBits<F>(FRegs[inst.rs1]));
+    F b = FromBits<F>(UnboxBits<F>(FRegs[inst.rs2]));
+    F c = FromBits<F>(UnboxBits<F>(FRegs[rs3]));
+
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+    if (op == OpcodeType::NMSUB || op == OpcodeType::NMADD) a = -a; // -(a * b) == (-a) * b
+    if (op == OpcodeType::MSUB || op == OpcodeType::NMADD) c = -c;
+
+    // inf * 0 is invalid even when the addend is a quiet NaN (the host may not flag it)
+    if ((std::isinf(a) && b == 0) || (a == 0 && std::isinf(b))) FFlags |= FLAG_NV;
+
+    F result;
+    {
+        HostFloatScope scope(rm, FFlags);
+        result = std::fma(a, b, c);
+    }
+    FRegs[inst.rd] = BoxResult(result);
+}
+
+template <typename F>
+bool RISCV_CPU::ExecuteFloatOp(const DecodedInstruction& inst, uint32_t& scalarResult) {
+    using Fmt = FloatFormat<F>;
+    using Bits = typename Fmt::Bits;
+
+    uint32_t funct5 = inst.funct7 >> 2;
+    uint32_t rm = (inst.funct3 == RM_DYN) ? FRM : inst.funct3;
+    Bits a_bits = UnboxBits<F>(FRegs[inst.rs1]);
+    Bits b_bits = UnboxBits<F>(FRegs[inst.rs2]);
+    F a = FromBits<F>(a_bits);
+    F b = FromBits<F>(b_bits);
+    F result = 0;
+
+    switch (funct5) {
+        // --- Arithmetic (one host instruction each) ---
+        case 0x00: { HostFloatScope scope(rm, FFlags); result = a + b; } break; // FADD
+        case 0x01: { HostFloatScope scope(rm, FFlags); result = a - b; } break; // FSUB
+        case 0x02: { HostFloatScope scope(rm, FFlags); result = a * b; } break; // FMUL
+        case 0x03: { HostFloatScope scope(rm, FFlags); result = a / b; } break; // FDIV
+        case 0x0B: { HostFloatScope scope(rm, FFlags); result = std::sqrt(a); } break; // FSQRT
+
+        case 0x04: { // FSGNJ / FSGNJN / FSGNJX (pure bit operations, no NaN canonicalization)
+            Bits sign = b_bits & Fmt::SIGN;
+            if (inst.funct3 == 0x1) sign ^= Fmt::SIGN;
+            if (inst.funct3 == 0x2) sign = (a_bits ^ b_bits) & Fmt::SIGN;
+            FRegs[inst.rd] = BoxBits<F>((a_bits & ~Fmt::SIGN) | sign);
+            return false;
+        }
+
+        case 0x05: { // FMIN / FMAX: a NaN operand loses, -0 < +0
+            bool is_max = (inst.funct3 == 0x1);
+            if (IsSignalingNaN<F>(a_bits) || IsSignalingNaN<F>(b_bits)) FFlags |= FLAG_NV;
+
+            Bits bits;
+            if (std::isnan(a) && std::isnan(b)) bits = Fmt::CANONICAL_NAN;
+            else if (std::isnan(a)) bits = b_bits;
+            else if (std::isnan(b)) bits = a_bits;
+            else if (a == b) bits = is_max ? (a_bits & b_bits) : (a_bits | b_bits); // Only differs for +0/-0
+            else bits = ((a < b) != is_max) ? a_bits : b_bits;
+            FRegs[inst.rd] = BoxBits<F>(bits);
+            return false;
+        }
+
+        case 0x08: { // FCVT.S.D / FCVT.D.S (F is the destination format)
+            using Source = std::conditional_t<std::is_same_v<F, float>, double, float>;
+            Source value = FromBits<Source>(UnboxBits<Source>(FRegs[inst.rs1]));
+            HostFloatScope scope(rm, FFlags);
+            result = (F)value;
+            break;
+        }
+
+        case 0x14: { // FEQ (quiet) / FLT, FLE (signaling): flags set by hand, not by the host compare
+            bool any_nan = std::isnan(a) || std::isnan(b);
+            bool is_quiet = (inst.funct3 == 0x2);
+            if (is_quiet ? (IsSignalingNaN<F>(a_bits) || IsSignalingNaN<F>(b_bits)) : any_nan) FFlags |= FLAG_NV;
+
+            bool compare = false;
+            if (!any_nan) {
+                if (inst.funct3 == 0x2) compare = (a == b); // FEQ
+                if (inst.funct3 == 0x1) compare = (a < b);  // FLT
+                if (inst.funct3 == 0x0) compare = (a <= b); // FLE
+            }
+            scalarResult = compare ? 1 : 0;
+            return true;
+        }
+
+        case 0x18: // FCVT.W / FCVT.WU (rs2 = 0 / 1)
+            scalarResult = ConvertToInt(a, rm, inst.rs2 == 1, FFlags);
+            return true;
+
+        case 0x1A: { // FCVT.S.W / FCVT.S.WU (and .D)
+            uint32_t x = Registers[inst.rs1];
+            HostFloatScope scope(rm, FFlags);
+            result = (inst.rs2 == 1) ? (F)x : (F)(int32_t)x;
+            break;
+        }
+
+        case 0x1C: // FMV.X.W (raw bits, single only) / FCLASS
+            if (inst.funct3 == 0x1) {
+                scalarResult = Classify<F>(a_bits);
+            } else {
+                scalarResult = (uint32_t)FRegs[inst.rs1];
+            }
+            return true;
+
+        case 0x1E: // FMV.W.X (single only)
+            FRegs[inst.rd] = NAN_BOX | Registers[inst.rs1];
+            return false;
+
+        default:
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+            return false;
+    }
+
+    FRegs[inst.rd] = BoxResult(result);
+    return false;
+}
@@ -0,0 +1,383 @@
+#include "RISCV_CPU.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+// Vector unit (RVV subset) of RISCV_CPU.
+//
+// Supported: vsetvli/vsetivli/vsetvl, unit-stride and strided loads/stores
+// (8/16/32-bit elements), integer add/sub/rsub/mul/and/or/xor, compares into a
+// mask register, vmerge/vmv, vredsum.vs and vmv.x.s/vmv.s.x, all maskable by v0.
+// Inactive and tail elements are left undisturbed.
+//
+// Every operation is a plain loop over a contiguous element array with the
+// operation passed in as a lambda, so the compiler turns each guest vector
+// instruction into a handful of host SIMD instructions (SSE/AVX2/AVX-512,
+// whatever the build targets). Masked variants select per element instead of
+// branching, which vectorizes the same way.
+
+namespace {
+
+// Largest possible vl: SEW = 8 with LMUL = 8
+constexpr uint32_t MAX_ELEMENTS = RISCV_CPU::VLEN;
+
+// --- OP-V funct3 (operand categories) ---
+constexpr uint32_t OPIVV = 0x0;
+constexpr uint32_t OPMVV = 0x2;
+constexpr uint32_t OPIVI = 0x3;
+constexpr uint32_t OPIVX = 0x4;
+constexpr uint32_t OPMVX = 0x6;
+constexpr uint32_t OPCFG = 0x7;
+
+// d = op(a, b) or op(a, x) when b is null. 'active' is null when unmasked.
+template <typename T, typename Op>
+void ApplyElementWise(T* d, const T* a, const T* b, T x, uint32_t vl, const uint8_t* active, Op op) {
+    if (b) {
+        if (active) {
+            for (uint32_t i = 0; i < vl; i++) d[i] = active[i] ? op(a[i], b[i]) : d[i];
+        } else {
+            for (uint32_t i = 0; i < vl; i++) d[i] = op(a[i], b[i]);
+        }
+    } else {
+        if (active) {
+            for (uint32_t i = 0; i < vl; i++) d[i] = active[i] ? op(a[i], x) : d[i];
+        } else {
+            for (uint32_t i = 0; i < vl; i++) d[i] = op(a[i], x);
+        }
+    }
+}
+
+// Mask-producing compare: bit i of 'maskOut' = op(a[i], b[i] or x)
+template <typename T, typename Op>
+void ApplyCompare(uint8_t* maskOut, const T* a, const T* b, T x, uint32_t vl, const uint8_t* active, Op op) {
+    uint8_t result[MAX_ELEMENTS];
+    if (b) {
+        for (uint32_t i = 0; i < vl; i++) result[i] = op(a[i], b[i]) ? 1 : 0;
+    } else {
+        for (uint32_t i = 0; i < vl; i++) result[i] = op(a[i], x) ? 1 : 0;
+    }
+
+    for (uint32_t i = 0; i < vl; i++) {
+        if (active && !active[i]) continue;
+        uint8_t bit = (uint8_t)(1 << (i & 7));
+        maskOut[i >> 3] = (uint8_t)((maskOut[i >> 3] & ~bit) | (result[i] ? bit : 0));
+    }
+}
+
+/**
+ * Integer arithmetic for one element width. Operand order follows the spec:
+ * vd = vs2 op vs1 (or vs2 op x / vs2 op imm). Returns false if not supported.
+ */
+template <typename T>
+bool ExecuteArithSEW(uint32_t funct3, uint32_t funct6, bool masked, uint8_t* vdBytes, const uint8_t* vs2Bytes,
+                     const uint8_t* vs1Bytes, uint32_t scalar, uint32_t vl, const uint8_t* active, const uint8_t* v0) {
+    using S = std::make_signed_t<T>;
+    T* d = reinterpret_cast<T*>(vdBytes);
+    const T* a = reinterpret_cast<const T*>(vs2Bytes);
+    const T* b = (funct3 == OPIVV || funct3 == OPMVV) ? reinterpret_cast<const T*>(vs1Bytes) : nullptr;
+    T x = (T)scalar;
+
+    if (funct3 == OPMVV || funct3 == OPMVX) {
+        switch (funct6) {
+            case 0x25: // VMUL
+                ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p * q); });
+                return true;
+
+            case 0x00: { // VREDSUM.VS: vd[0] = vs1[0] + sum(vs2[active])
+                if (!b) return false;
+                T sum = b[0];
+                for (uint32_t i = 0; i < vl; i++) sum = (T)(sum + ((!active || active[i]) ? a[i] : 0));
+                if (vl) d[0] = sum; // vl = 0 leaves vd alone
+                return true;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    switch (funct6) {
+        case 0x00: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p + q); }); return true; // VADD
+        case 0x02: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p - q); }); return true; // VSUB
+        case 0x03: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(q - p); }); return true; // VRSUB
+        case 0x09: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p & q); }); return true; // VAND
+        case 0x0A: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p | q); }); return true; // VOR
+        case 0x0B: ApplyElementWise(d, a, b, x, vl, active, [](T p, T q) { return (T)(p ^ q); }); return true; // VXOR
+
+        case 0x17: // VMERGE (masked: v0 picks vs1/x over vs2) / VMV.V (unmasked)
+            if (masked) {
+                for (uint32_t i = 0; i < vl; i++) {
+                    bool pick = (v0[i >> 3] >> (i & 7)) & 1;
+                    d[i] = pick ? (b ? b[i] : x) : a[i];
+                }
+            } else {
+                for (uint32_t i = 0; i < vl; i++) d[i] = b ? b[i] : x;
+            }
+            return true;
+
+        // Compares write one mask bit per element into vd
+        case 0x18: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return p == q; }); return true;        // VMSEQ
+        case 0x19: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return p != q; }); return true;        // VMSNE
+        case 0x1A: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return p < q; }); return true;         // VMSLTU
+        case 0x1B: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return (S)p < (S)q; }); return true;   // VMSLT
+        case 0x1C: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return p <= q; }); return true;        // VMSLEU
+        case 0x1D: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return (S)p <= (S)q; }); return true;  // VMSLE
+        case 0x1E: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return p > q; }); return true;         // VMSGTU
+        case 0x1F: ApplyCompare(vdBytes, a, b, x, vl, active, [](T p, T q) { return (S)p > (S)q; }); return true;   // VMSGT
+
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+void RISCV_CPU::ResetVectorUnit() {
+    std::fill(VectorRegs, VectorRegs + sizeof(VectorRegs), 0);
+    VL = 0;
+    VType = VTYPE_VILL; // No valid configuration until the first vsetvl(i)
+    VStart = 0;
+}
+
+const uint8_t* RISCV_CPU::GetVectorRegister(int reg_index) const {
+    if (reg_index < 0 || reg_index > 31) return nullptr;
+    return VectorRegs + reg_index * VLENB;
+}
+
+uint32_t RISCV_CPU::GetVL() const {
+    return VL;
+}
+
+bool RISCV_CPU::ExecuteVector(const DecodedInstruction& inst, uint32_t& scalarResult) {
+    // Vector registers are invisible to idle-loop detection, so count every vector
+    // instruction as a write: a loop doing vector work is never "idle"
+    WriteCount++;
+
+    bool writes_rd = false;
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+
+    if (op == OpcodeType::LOAD_FP || op == OpcodeType::STORE_FP) {
+        ExecuteVectorMemory(inst, op == OpcodeType::STORE_FP);
+    } else if (inst.funct3 == OPCFG) {
+        // vsetvli: zimm[10:0] | vsetivli: 11, zimm[9:0], uimm in rs1 | vsetvl: 1000000, rs2
+        uint32_t vtype;
+        uint32_t avl;
+        bool keep_vl = false;
+        if ((inst.raw >> 31) == 0) {
+            vtype = (inst.raw >> 20) & 0x7FF;
+            avl = Registers[inst.rs1];
+        } else if ((inst.raw >> 30) == 0x3) {
+            vtype = (inst.raw >> 20) & 0x3FF;
+            avl = inst.rs1;
+        } else if ((inst.raw >> 25) == 0x40) {
+            vtype = Registers[inst.rs2];
+            avl = Registers[inst.rs1];
+        } else {
+            RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+            return false;
+        }
+
+        // rs1 = x0 (register forms): AVL = VLMAX if rd != x0, otherwise keep vl
+        if ((inst.raw >> 30) != 0x3 && inst.rs1 == 0) {
+            avl = UINT32_MAX;
+            keep_vl = (inst.rd == 0);
+        }
+        scalarResult = SetVectorConfig(avl, vtype, keep_vl);
+        writes_rd = true;
+    } else {
+        writes_rd = ExecuteVectorArith(inst, scalarResult);
+    }
+
+    VStart = 0; // Every instruction runs to completion
+    return writes_rd;
+}
+
+void RISCV_CPU::RecordVectorUndo(const DecodedInstruction& inst) {
+    uint8_t config[13] = { UNDO_VCONFIG };
+    std::memcpy(config + 1, &VL, 4);
+    std::memcpy(config + 5, &VType, 4);
+    std::memcpy(config + 9, &VStart, 4);
+    UndoLog.AppendExtra(config, sizeof(config));
+
+    // Stores and vset* write no vector register
+    if (inst.opcode == static_cast<uint32_t>(OpcodeType::STORE_FP)) return;
+    if (inst.opcode == static_cast<uint32_t>(OpcodeType::OP_V) && inst.funct3 == OPCFG) return;
+
+    // Save the whole group the destination can span: LMUL registers, or up to
+    // 4x that for a load whose EEW is wider than SEW. Over-saving is harmless.
+    uint32_t vd = inst.rd;
+    uint32_t group = (VType & VTYPE_VILL) ? 1 : 1u << (VType & 0x7);
+    if (inst.opcode == static_cast<uint32_t>(OpcodeType::LOAD_FP)) group *= 4;
+    group = std::min(std::min(group, 8u), 32 - vd);
+
+    uint8_t header[3] = { UNDO_VREGS, (uint8_t)vd, (uint8_t)group };
+    UndoLog.AppendExtra(header, sizeof(header));
+    UndoLog.AppendExtra(VectorRegs + vd * VLENB, group * VLENB);
+}
+
+uint32_t RISCV_CPU::SetVectorConfig(uint32_t avl, uint32_t vtype, bool keepVL) {
+    uint32_t lmul_bits = vtype & 0x7;
+    uint32_t sew_bits = (vtype >> 3) & 0x7;
+
+    // Supported: SEW 8/16/32, integral LMUL 1/2/4/8 (ta/ma bits accepted, treated as undisturbed)
+    if (sew_bits > 2 || lmul_bits > 3 || (vtype >> 8) != 0) {
+        VType = VTYPE_VILL;
+        VL = 0;
+        return 0;
+    }
+
+    uint32_t vlmax = (VLEN << lmul_bits) >> (3 + sew_bits); // VLEN * LMUL / SEW
+    VType = vtype;
+    VL = keepVL ? std::min(VL, vlmax) : std::min(avl, vlmax);
+    return VL;
+}
+
+void RISCV_CPU::ExecuteVectorMemory(const DecodedInstruction& inst, bool isStore) {
+    uint32_t width = inst.funct3;
+    uint32_t mop = (inst.raw >> 26) & 0x3;
+    uint32_t nf = inst.raw >> 29;
+    bool masked = ((inst.raw >> 25) & 1) == 0;
+
+    // Element width comes from the instruction, not from SEW
+    int eew_bytes = 0;
+    if (width == 0x0) eew_bytes = 1;
+    if (width == 0x5) eew_bytes = 2;
+    if (width == 0x6) eew_bytes = 4;
+
+    if (eew_bytes == 0 || nf != 0 || (mop != 0x0 && mop != 0x2) || (mop == 0x0 && inst.rs2 != 0)) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return;
+    }
+    if (VType & VTYPE_VILL) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return;
+    }
+
+    // The register group spans EMUL = EEW / SEW * LMUL registers. EMUL > 8 is reserved,
+    // and a group must start at a multiple of EMUL (fractional EMUL uses one register).
+    uint32_t vreg = inst.rd; // vd for loads, vs3 for stores
+    uint32_t sew_bytes = 1u << ((VType >> 3) & 0x7);
+    uint32_t emul_sew = (uint32_t)eew_bytes << (VType & 0x7); // EMUL * SEW, in bytes
+    if (emul_sew > 8 * sew_bytes || (emul_sew >= sew_bytes && vreg % (emul_sew / sew_bytes))) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return;
+    }
+
+    uint32_t bytes = VL * eew_bytes;
+    if (vreg * VLENB + bytes > sizeof(VectorRegs)) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return;
+    }
+    if (VL == 0) return;
+
+    uint8_t* elems = VectorRegs + vreg * VLENB;
+    uint32_t base = Registers[inst.rs1];
+    uint32_t stride = (mop == 0x2) ? Registers[inst.rs2] : (uint32_t)eew_bytes;
+
+    // Fast path: untranslated, contiguous, unmasked, all in RAM and no watchpoint on either
+    // page (EMUL <= 8 caps an access at 8 registers = 512 bytes, so it spans at most two pages).
+    // A page that cannot be loaded takes the slow path, which faults at the first element on it.
+    if (!bTranslate && !masked && stride == (uint32_t)eew_bytes && base <= MEMORY_SIZE - bytes) {
+        uint8_t flag = isStore ? WATCH_WRITE : WATCH_READ;
+        uint8_t flags = WatchPageFlags[(base >> PAGE_SHIFT) & WATCH_PAGE_MASK] |
+                        WatchPageFlags[((base + bytes - 1) >> PAGE_SHIFT) & WATCH_PAGE_MASK];
+        if (!(flags & flag) && LoadIfPending(base, bytes)) {
+            if (TraceSink) TraceSink->OnAccess(base, bytes, isStore ? RISCV_TraceSink::Store : RISCV_TraceSink::Load);
+            if (isStore) {
+                MarkWritten(base, (int)bytes);
+                NoteStore(base, bytes);
+                if (bUndoStores) RecordMemoryUndo(base, bytes);
+                std::memcpy(Memory + base, elems, bytes);
+            } else {
+                std::memcpy(elems, Memory + base, bytes);
+            }
+            return;
+        }
+    }
+
+    // Slow path: one element at a time through MemRead/MemWrite (devices, watchpoints, masks, strides)
+    const uint8_t* v0 = VectorRegs;
+    for (uint32_t i = 0; i < VL && !bTrapPending; i++) { // A page fault stops at the faulting element
+        if (masked && !((v0[i >> 3] >> (i & 7)) & 1)) continue;
+
+        uint32_t addr = base + i * stride;
+        uint8_t* elem = elems + i * eew_bytes;
+        if (isStore) {
+            uint32_t value = 0;
+            std::memcpy(&value, elem, eew_bytes);
+            MemWrite(addr, value, eew_bytes);
+        } else {
+            uint32_t value = MemRead(addr, eew_bytes, false);
+            std::memcpy(elem, &value, eew_bytes);
+        }
+    }
+}
+
+bool RISCV_CPU::ExecuteVectorArith(const DecodedInstruction& inst, uint32_t& scalarResult) {
+    uint32_t funct3 = inst.funct3;
+    uint32_t funct6 = inst.raw >> 26;
+    bool masked = ((inst.raw >> 25) & 1) == 0;
+    uint32_t vd = inst.rd;
+    uint32_t vs1 = inst.rs1;
+    uint32_t vs2 = inst.rs2;
+
+    if (VType & VTYPE_VILL) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return false;
+    }
+
+    uint32_t sew_bytes = 1u << ((VType >> 3) & 0x7);
+
+    // Scalar moves work on element 0 and ignore LMUL
+    if (funct3 == OPMVV && funct6 == 0x10 && vs1 == 0) { // VMV.X.S (sign-extended)
+        const uint8_t* e = VectorRegs + vs2 * VLENB;
+        if (sew_bytes == 1) scalarResult = (uint32_t)(int32_t)(int8_t)e[0];
+        if (sew_bytes == 2) scalarResult = (uint32_t)(int32_t)(int16_t)(e[0] | (e[1] << 8));
+        if (sew_bytes == 4) std::memcpy(&scalarResult, e, 4);
+        return true;
+    }
+    if (funct3 == OPMVX && funct6 == 0x10 && vs2 == 0) { // VMV.S.X
+        if (VL > 0) std::memcpy(VectorRegs + vd * VLENB, &Registers[vs1], sew_bytes);
+        return false;
+    }
+
+    // Register groups must be aligned to LMUL (mask results and reductions only use one register)
+    uint32_t lmul = 1u << (VType & 0x7);
+    bool single_vd = (funct6 >= 0x18 && funct6 <= 0x1F) || (funct3 == OPMVV && funct6 == 0x00);
+    if ((!single_vd && vd % lmul) || vs2 % lmul || ((funct3 == OPIVV || (funct3 == OPMVV && funct6 != 0x00)) && vs1 % lmul)) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw);
+        return false;
+    }
+
+    // Scalar operand: x[rs1] for .vx, sign-extended simm5 for .vi
+    uint32_t scalar = Registers[vs1];
+    if (funct3 == OPIVI) {
+        scalar = (uint32_t)(((int32_t)(vs1 << 27)) >> 27);
+    }
+
+    // Expand the v0 mask once so the element loops can select without bit twiddling
+    uint8_t active_storage[MAX_ELEMENTS];
+    const uint8_t* active = nullptr;
+    if (masked && funct6 != 0x17) { // VMERGE reads v0 itself
+        for (uint32_t i = 0; i < VL; i++) {
+            active_storage[i] = (VectorRegs[i >> 3] >> (i & 7)) & 1;
+        }
+        active = active_storage;
+    }
+
+    uint8_t* d = VectorRegs + vd * VLENB;
+    const uint8_t* a = VectorRegs + vs2 * VLENB;
+    const uint8_t* b = VectorRegs + vs1 * VLENB;
+    bool ok = false;
+    switch (sew_bytes) {
+        case 1: ok = ExecuteArithSEW<uint8_t>(funct3, funct6, masked, d, a, b, scalar, VL, active, VectorRegs); break;
+        case 2: ok = ExecuteArithSEW<uint16_t>(funct3, funct6, masked, d, a, b, scalar, VL, active, VectorRegs); break;
+        case 4: ok = ExecuteArithSEW<uint32_t>(funct3, funct6, masked, d, a, b, scalar, VL, active, VectorRegs); break;
+        default: break;
+    }
+
+    if (!ok) {
+        RaiseTrap(CAUSE_ILLEGAL_INSTRUCTION, inst.raw); // Unknown funct6 for this operand category
+    }
+    return false;
+}
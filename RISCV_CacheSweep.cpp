@@ -0,0 +1,204 @@
+#include "RISCV_CacheSweep.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+
+namespace {
+    constexpr uint32_t EMPTY_LINE = 0xFFFFFFFF; // Line numbers are at most 32 - 5 bits wide
+
+    // Runs fn(0) .. fn(count - 1) on up to 'threads' host threads, handing out indices in order
+    template <typename Fn>
+    void ParallelFor(size_t count, uint32_t threads, Fn&& fn) {
+        std::atomic<size_t> next_item{ 0 };
+        auto worker = [&]() {
+            for (size_t i = next_item++; i < count; i = next_item++) {
+                fn(i);
+            }
+        };
+
+        threads = (uint32_t)std::min<size_t>(threads, count);
+        if (threads <= 1) {
+            worker();
+            return;
+        }
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (uint32_t t = 0; t < threads; t++) {
+            pool.emplace_back(worker);
+        }
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+    }
+}
+
+RISCV_CacheSweep::RISCV_CacheSweep(const std::vector<uint32_t>& lineSizes, uint32_t maxSets, uint32_t maxWays) {
+    for (uint32_t size : lineSizes) {
+        if (size < 4 || !std::has_single_bit(size)) {
+            std::cerr << "Error: Cache Line Size " << std::dec << size << " is not a power of two >= 4" << std::endl;
+            continue;
+        }
+        LineSizes.push_back(size);
+    }
+    MaxSets = std::bit_floor(std::max<uint32_t>(maxSets, 1));
+    MaxWays = std::max<uint32_t>(maxWays, 1);
+    HistStride = (MaxWays + 1 + 7) & ~7u;
+    Threads = 0;
+    StreamMask = (1 << Load) | (1 << Store);
+    Reset();
+}
+
+void RISCV_CacheSweep::SetStreams(bool fetches, bool loads, bool stores) {
+    StreamMask = (fetches ? 1 << Fetch : 0) | (loads ? 1 << Load : 0) | (stores ? 1 << Store : 0);
+}
+
+void RISCV_CacheSweep::SetThreads(uint32_t threads) {
+    Threads = threads;
+    Reset(); // The partitioning depends on the thread count
+}
+
+void RISCV_CacheSweep::Reset() {
+    uint32_t threads = Threads ? Threads : std::max(1u, std::thread::hardware_concurrency());
+
+    // A few partitions per thread, so small geometries (which cannot be split) balance out
+    PartitionCount = threads == 1 ? 1 : std::bit_ceil(threads * 2);
+
+    Geometries.clear();
+    for (uint32_t i = 0; i < LineSizes.size(); i++) {
+        for (uint32_t sets = 1; sets <= MaxSets; sets <<= 1) {
+            Geometry geometry;
+            geometry.LineShift = (uint32_t)std::countr_zero(LineSizes[i]);
+            geometry.LineSizeIndex = i;
+            geometry.SetMask = sets - 1;
+            // Splitting fewer sets would need each bucket's lines back in program order
+            geometry.Partitions = sets >= PartitionCount ? PartitionCount : 1;
+            geometry.Stacks.assign((size_t)sets * MaxWays, EMPTY_LINE);
+            geometry.Histogram.assign((size_t)geometry.Partitions * HistStride, 0);
+            Geometries.push_back(std::move(geometry));
+        }
+    }
+
+    Buffer.clear();
+    Buffer.reserve(BATCH_SIZE);
+    Buckets.assign(PartitionCount > 1 ? LineSizes.size() : 0, std::vector<std::vector<uint32_t>>(PartitionCount));
+}
+
+void RISCV_CacheSweep::OnAccess(uint32_t addr, uint32_t size, AccessKind kind) {
+    if (!(StreamMask & (1 << kind))) return;
+
+    Buffer.push_back({ addr, size });
+    if (Buffer.size() >= BATCH_SIZE) Flush();
+}
+
+void RISCV_CacheSweep::Flush() {
+    if (Buffer.empty()) return;
+
+    uint32_t threads = Threads ? Threads : std::max(1u, std::thread::hardware_concurrency());
+
+    // Split the batch's lines by partition, one line size per thread
+    ParallelFor(Buckets.size(), threads, [&](size_t i) { BucketLines((uint32_t)i); });
+
+    // Work items are (geometry, partition) pairs, handed out to threads in order
+    struct WorkItem {
+        uint32_t Geometry;
+        uint32_t Partition;
+    };
+    std::vector<WorkItem> items;
+    for (uint32_t g = 0; g < Geometries.size(); g++) {
+        for (uint32_t p = 0; p < Geometries[g].Partitions; p++) {
+            items.push_back({ g, p });
+        }
+    }
+    ParallelFor(items.size(), threads, [&](size_t i) {
+        ReplayPartition(Geometries[items[i].Geometry], items[i].Partition);
+    });
+
+    Buffer.clear();
+}
+
+void RISCV_CacheSweep::BucketLines(uint32_t lineSizeIndex) {
+    std::vector<std::vector<uint32_t>>& buckets = Buckets[lineSizeIndex];
+    uint32_t line_shift = (uint32_t)std::countr_zero(LineSizes[lineSizeIndex]);
+    uint32_t partition_mask = PartitionCount - 1;
+
+    for (std::vector<uint32_t>& bucket : buckets) {
+        bucket.clear();
+    }
+    for (const Access& access : Buffer) {
+        uint32_t first = access.Addr >> line_shift;
+        uint32_t last = (access.Addr + access.Size - 1) >> line_shift;
+        for (uint32_t line = first; line <= last; line++) {
+            buckets[line & partition_mask].push_back(line);
+        }
+    }
+}
+
+void RISCV_CacheSweep::ReplayPartition(Geometry& geometry, uint32_t partition) {
+    uint64_t* histogram = &geometry.Histogram[(size_t)partition * HistStride];
+
+    auto touch = [&](uint32_t line) {
+        // Depth of the line in its set's LRU stack (MaxWays = not present)
+        uint32_t* stack = &geometry.Stacks[(size_t)(line & geometry.SetMask) * MaxWays];
+        uint32_t depth = 0;
+        while (depth < MaxWays && stack[depth] != line) depth++;
+        histogram[depth]++;
+
+        // Move it to the top; on a miss the least recently used line drops off the bottom
+        uint32_t moved = std::min(depth, MaxWays - 1);
+        std::memmove(stack + 1, stack, moved * sizeof(uint32_t));
+        stack[0] = line;
+    };
+
+    if (geometry.Partitions == 1) {
+        for (const Access& access : Buffer) {
+            uint32_t first = access.Addr >> geometry.LineShift;
+            uint32_t last = (access.Addr + access.Size - 1) >> geometry.LineShift;
+            for (uint32_t line = first; line <= last; line++) {
+                touch(line);
+            }
+        }
+    } else {
+        // The set index includes the partition bits, so every line here maps to one of our sets
+        for (uint32_t line : Buckets[geometry.LineSizeIndex][partition]) {
+            touch(line);
+        }
+    }
+}
+
+std::vector<RISCV_CacheSweep::Result> RISCV_CacheSweep::GetResults() {
+    Flush();
+
+    std::vector<Result> results;
+    std::vector<uint64_t> depths(MaxWays + 1);
+    for (const Geometry& geometry : Geometries) {
+        std::fill(depths.begin(), depths.end(), 0);
+        for (uint32_t p = 0; p < geometry.Partitions; p++) {
+            for (uint32_t d = 0; d <= MaxWays; d++) {
+                depths[d] += geometry.Histogram[(size_t)p * HistStride + d];
+            }
+        }
+
+        uint64_t accesses = 0;
+        for (uint64_t count : depths) accesses += count;
+
+        // A cache with 'ways' ways hits every access found above depth 'ways'
+        uint64_t hits = 0;
+        for (uint32_t ways = 1; ways <= MaxWays; ways++) {
+            hits += depths[ways - 1];
+            results.push_back({ 1u << geometry.LineShift, geometry.SetMask + 1, ways, accesses, accesses - hits });
+        }
+    }
+    return results;
+}
+
+void RISCV_CacheSweep::WriteCSV(std::ostream& out) {
+    out << "line_size,sets,ways,capacity,accesses,misses,miss_rate\n";
+    for (const Result& result : GetResults()) {
+        uint64_t capacity = (uint64_t)result.LineSize * result.Sets * result.Ways;
+        double miss_rate = result.Accesses ? (double)result.Misses / (double)result.Accesses : 0.0;
+        out << std::dec << result.LineSize << ',' << result.Sets << ',' << result.Ways << ','
+            << capacity << ',' << result.Accesses << ',' << result.Misses << ',' << miss_rate << '\n';
+    }
+}
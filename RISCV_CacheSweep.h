@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "RISCV_CPU.h"
+
+/**
+ * Single-pass cache design-space sweep over a core's memory access stream.
+ *
+ * Attach with RISCV_CPU::SetTraceSink and run the guest once. For every line
+ * size and power-of-two set count, each set keeps an LRU stack of the last
+ * MaxWays lines it saw. An access that finds its line at depth d hits in every
+ * LRU cache of that geometry with more than d ways (the inclusion property),
+ * so one histogram of stack depths gives the miss rate of all associativities
+ * at once: a whole miss-rate curve from one simulation.
+ *
+ * Accesses are buffered and replayed in batches. Within a geometry the sets
+ * are split across host threads by the low bits of the set index, so no two
+ * threads ever touch the same stack and the replay needs no locks. Each batch
+ * is bucketed by those bits once per line size, so a partition only walks its
+ * own lines. Geometries with fewer sets than partitions are replayed whole.
+ */
+class RISCV_CacheSweep : public RISCV_TraceSink {
+public:
+    // Line sizes in bytes (powers of two). Set counts run 1, 2, 4, ... maxSets.
+    explicit RISCV_CacheSweep(const std::vector<uint32_t>& lineSizes = { 32, 64, 128 },
+                              uint32_t maxSets = 4096, uint32_t maxWays = 16);
+
+    // Which accesses to simulate (default: a data cache, i.e. loads and stores)
+    void SetStreams(bool fetches, bool loads, bool stores);
+    void SetThreads(uint32_t threads); // 0 = one per host core. Resets the sweep.
+
+    void OnAccess(uint32_t addr, uint32_t size, AccessKind kind) override;
+
+    struct Result {
+        uint32_t LineSize;
+        uint32_t Sets;
+        uint32_t Ways;
+        uint64_t Accesses; // Line accesses (an access spanning two lines counts twice)
+        uint64_t Misses;
+    };
+
+    // Replays anything still buffered, then returns one entry per (line size, sets, ways)
+    std::vector<Result> GetResults();
+
+    // The same as CSV: line_size,sets,ways,capacity,accesses,misses,miss_rate
+    void WriteCSV(std::ostream& out);
+
+    void Reset();
+
+    static const size_t BATCH_SIZE = 1 << 20; // Buffered accesses per replay
+
+private:
+    struct Access {
+        uint32_t Addr;
+        uint32_t Size;
+    };
+
+    // One (line size, set count) pair
+    struct Geometry {
+        uint32_t LineShift;
+        uint32_t LineSizeIndex;          // Into Buckets
+        uint32_t SetMask;
+        uint32_t Partitions;             // 1, or PartitionCount if it has at least that many sets
+        std::vector<uint32_t> Stacks;    // Sets * MaxWays line numbers, most recent first
+        std::vector<uint64_t> Histogram; // Partitions * HistStride; bin MaxWays counts misses
+    };
+
+    void Flush();
+    void BucketLines(uint32_t lineSizeIndex);
+    void ReplayPartition(Geometry& geometry, uint32_t partition);
+
+    std::vector<uint32_t> LineSizes;
+    uint32_t MaxSets;
+    uint32_t MaxWays;
+    uint32_t HistStride; // MaxWays + 1 rounded up to a cache line, so threads do not share one
+    uint32_t Threads;
+    uint32_t PartitionCount; // Power of two
+    uint8_t StreamMask;  // Bit per RISCV_TraceSink::AccessKind
+
+    std::vector<Geometry> Geometries;
+    std::vector<Access> Buffer;
+    std::vector<std::vector<std::vector<uint32_t>>> Buckets; // [line size][partition] -> Buffer's line numbers, in order
+};
@@ -0,0 +1,361 @@
+#include "RISCV_CheckpointFile.h"
+#include "RISCV_MappedFile.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+const uint32_t PAGE_SIZE = RISCV_CPU::PAGE_SIZE;
+const uint32_t NUM_PAGES = RISCV_CPU::NUM_PAGES;
+const uint32_t VECTOR_BYTES = 32 * RISCV_CPU::VLENB;
+
+const uint32_t RECORD_SIZE = 20; // Page table entry in the file
+
+struct PageRecord {
+    uint32_t Page;
+    uint32_t StoredSize;
+    uint64_t Offset;
+    uint32_t Checksum; // Crc32 of the StoredSize bytes at Offset
+};
+
+// --- Page checksums ---
+// CRC-32 (IEEE, reflected), one table lookup per byte. Only a page the hart touches is
+// checked, when it is first loaded, so a damaged record is caught without reading the rest.
+
+constexpr std::array<uint32_t, 256> MakeCrcTable() {
+    std::array<uint32_t, 256> table = {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = MakeCrcTable();
+
+uint32_t Crc32(const uint8_t* bytes, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = (crc >> 8) ^ CRC_TABLE[(crc ^ bytes[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+// --- Little-endian encoding ---
+// The file is an interchange format, so nothing is written in host byte order.
+
+void Put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (i * 8)));
+}
+
+void Put64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back((uint8_t)(value >> (i * 8)));
+}
+
+// Reads fields in order; running past the end clears bOk and yields zeros
+struct Reader {
+    const uint8_t* Pos;
+    const uint8_t* End;
+    bool bOk = true;
+
+    const uint8_t* Take(size_t count) {
+        if (!bOk || (size_t)(End - Pos) < count) {
+            bOk = false;
+            return nullptr;
+        }
+        const uint8_t* bytes = Pos;
+        Pos += count;
+        return bytes;
+    }
+    uint64_t Get(int size) {
+        const uint8_t* bytes = Take(size);
+        uint64_t value = 0;
+        for (int i = 0; bytes && i < size; i++) value |= (uint64_t)bytes[i] << (i * 8);
+        return value;
+    }
+    uint32_t Get32() { return (uint32_t)Get(4); }
+    uint64_t Get64() { return Get(8); }
+};
+
+// --- Page compression ---
+// LZ77 in the LZ4 block layout: each sequence is a token (literal count in the high
+// nibble, match length - 4 in the low one, 15 = more length bytes follow), the literals,
+// then a 16-bit back offset. The last sequence has literals only. Guest pages are mostly
+// zero runs, repeated words and code, which a single-probe hash table finds cheaply.
+
+const uint32_t MIN_MATCH = 4;
+const int HASH_BITS = 12;
+
+uint32_t Load32(const uint8_t* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, 4);
+    return value;
+}
+
+void PutLength(std::vector<uint8_t>& out, uint32_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((uint8_t)length);
+}
+
+bool GetLength(const uint8_t*& in, const uint8_t* end, uint32_t& length) {
+    uint8_t byte;
+    do {
+        if (in == end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void PutSequence(std::vector<uint8_t>& out, const uint8_t* literals, uint32_t literalCount, uint32_t offset, uint32_t matchLength) {
+    uint32_t match_code = matchLength ? matchLength - MIN_MATCH : 0;
+    out.push_back((uint8_t)((std::min(literalCount, 15u) << 4) | std::min(match_code, 15u)));
+    if (literalCount >= 15) PutLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+
+    if (matchLength == 0) return; // Last sequence
+    out.push_back((uint8_t)offset);
+    out.push_back((uint8_t)(offset >> 8));
+    if (match_code >= 15) PutLength(out, match_code - 15);
+}
+
+std::vector<uint8_t> CompressPage(const uint8_t* page) {
+    std::vector<uint8_t> out;
+    out.reserve(PAGE_SIZE);
+
+    // Most recent position of each hashed 4-byte prefix
+    int32_t recent[1 << HASH_BITS];
+    std::fill(recent, recent + (1 << HASH_BITS), -1);
+
+    uint32_t pos = 0;
+    uint32_t anchor = 0; // Start of the literals not yet emitted
+    while (pos + MIN_MATCH <= PAGE_SIZE) {
+        uint32_t prefix = Load32(page + pos);
+        uint32_t hash = (prefix * 2654435761u) >> (32 - HASH_BITS);
+        int32_t candidate = recent[hash];
+        recent[hash] = (int32_t)pos;
+
+        if (candidate < 0 || Load32(page + candidate) != prefix) {
+            pos++;
+            continue;
+        }
+
+        // Overlapping matches are allowed, so a zero run becomes a single sequence
+        uint32_t length = MIN_MATCH;
+        while (pos + length < PAGE_SIZE && page[candidate + length] == page[pos + length]) {
+            length++;
+        }
+        PutSequence(out, page + anchor, pos - anchor, pos - (uint32_t)candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    PutSequence(out, page + anchor, PAGE_SIZE - anchor, 0, 0);
+    return out;
+}
+
+// Checks every length and offset, since the file may come from anywhere
+bool DecompressPage(const uint8_t* in, uint32_t inSize, uint8_t* page) {
+    const uint8_t* end = in + inSize;
+    uint32_t pos = 0;
+
+    while (in < end) {
+        uint8_t token = *in++;
+
+        uint32_t literal_count = token >> 4;
+        if (literal_count == 15 && !GetLength(in, end, literal_count)) return false;
+        if (literal_count > (uint32_t)(end - in) || literal_count > PAGE_SIZE - pos) return false;
+        std::memcpy(page + pos, in, literal_count);
+        in += literal_count;
+        pos += literal_count;
+
+        if (in == end) break; // Last sequence
+        if (end - in < 2) return false;
+        uint32_t offset = (uint32_t)in[0] | ((uint32_t)in[1] << 8);
+        in += 2;
+        uint32_t length = token & 0xF;
+        if (length == 15 && !GetLength(in, end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > pos || length > PAGE_SIZE - pos) return false;
+
+        // Byte by byte: the source may overlap what is being written
+        for (uint32_t i = 0; i < length; i++) {
+            page[pos + i] = page[pos - offset + i];
+        }
+        pos += length;
+    }
+    return pos == PAGE_SIZE;
+}
+
+} // namespace
+
+bool RISCV_CheckpointFile::Save(RISCV_CPU& cpu, const std::string& path) {
+    // Pages written since the image was loaded come from the checkpoint (which also
+    // covers any still pending from a lazy Load), every other page holds the image
+    ArchCheckpoint checkpoint = cpu.SaveCheckpoint();
+    const uint8_t* ram = cpu.GetSharedMemory()->Bytes.data();
+    std::vector<const uint8_t*> pages(NUM_PAGES);
+    for (uint32_t page = 0; page < NUM_PAGES; page++) {
+        pages[page] = ram + page * PAGE_SIZE;
+    }
+    for (size_t i = 0; i < checkpoint.PageNumbers.size(); i++) {
+        pages[checkpoint.PageNumbers[i]] = checkpoint.PageData.data() + i * PAGE_SIZE;
+    }
+
+    std::vector<uint8_t> state;
+    for (int i = 0; i < 32; i++) Put32(state, checkpoint.Registers[i]);
+    Put32(state, checkpoint.PC);
+    Put64(state, checkpoint.CycleCount);
+    for (int i = 0; i < 32; i++) Put64(state, checkpoint.FloatRegisters[i]);
+    for (uint32_t value : { checkpoint.FCSR, checkpoint.Privilege, checkpoint.Satp, checkpoint.MStatus, checkpoint.MTvec,
+                            checkpoint.MEpc, checkpoint.MCause, checkpoint.MTval, checkpoint.MScratch, checkpoint.VL, checkpoint.VType,
+                            checkpoint.VStart, (uint32_t)checkpoint.bHalted }) {
+        Put32(state, value);
+    }
+    state.insert(state.end(), checkpoint.VectorRegs.begin(), checkpoint.VectorRegs.end());
+
+    // Zero pages are left out; one that does not shrink is stored as is
+    std::vector<PageRecord> records;
+    std::vector<uint8_t> data;
+    for (uint32_t page = 0; page < NUM_PAGES; page++) {
+        const uint8_t* bytes = pages[page];
+        if (std::all_of(bytes, bytes + PAGE_SIZE, [](uint8_t byte) { return byte == 0; })) continue;
+
+        std::vector<uint8_t> compressed = CompressPage(bytes);
+        PageRecord record = { page, (uint32_t)compressed.size(), data.size(), 0 };
+        if (compressed.size() >= PAGE_SIZE) {
+            record.StoredSize = PAGE_SIZE;
+            data.insert(data.end(), bytes, bytes + PAGE_SIZE);
+        } else {
+            data.insert(data.end(), compressed.begin(), compressed.end());
+        }
+        record.Checksum = Crc32(data.data() + record.Offset, record.StoredSize);
+        records.push_back(record);
+    }
+
+    std::vector<uint8_t> head;
+    for (uint32_t value : { FILE_MAGIC, FILE_VERSION, PAGE_SIZE, RISCV_CPU::MEMORY_SIZE, VECTOR_BYTES, (uint32_t)records.size() }) {
+        Put32(head, value);
+    }
+    head.insert(head.end(), state.begin(), state.end());
+    uint64_t data_start = head.size() + records.size() * RECORD_SIZE;
+    for (const PageRecord& record : records) {
+        Put32(head, record.Page);
+        Put32(head, record.StoredSize);
+        Put64(head, data_start + record.Offset);
+        Put32(head, record.Checksum);
+    }
+
+    // Write a temporary file and rename it over the old one, so a crash never leaves a
+    // partial checkpoint (or no checkpoint at all)
+    std::string temp_path = path + ".tmp";
+    std::error_code error;
+    bool written;
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(head.data()), (std::streamsize)head.size());
+        out.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+        out.close();
+        written = !out.fail();
+    }
+    if (written) {
+        std::filesystem::rename(temp_path, path, error);
+        if (!error) return true;
+    }
+    std::filesystem::remove(temp_path, error);
+    std::cerr << "Error: Could not write checkpoint " << path << std::endl;
+    return false;
+}
+
+bool RISCV_CheckpointFile::Load(RISCV_CPU& cpu, const std::string& path, bool lazy) {
+    auto file = std::make_shared<RISCV_MappedFile>();
+    if (!file->Open(path)) {
+        std::cerr << "Error: Could not open checkpoint " << path << std::endl;
+        return false;
+    }
+    Reader reader{ file->GetData(), file->GetData() + file->GetSize() };
+
+    uint32_t magic = reader.Get32();
+    uint32_t version = reader.Get32();
+    uint32_t page_size = reader.Get32();
+    uint32_t memory_size = reader.Get32();
+    uint32_t vector_bytes = reader.Get32();
+    uint32_t page_count = reader.Get32();
+    if (!reader.bOk || magic != FILE_MAGIC || version != FILE_VERSION) {
+        std::cerr << "Error: Not a checkpoint file (or a newer version): " << path << std::endl;
+        return false;
+    }
+    if (page_size != PAGE_SIZE || memory_size > RISCV_CPU::MEMORY_SIZE || vector_bytes != VECTOR_BYTES || page_count > NUM_PAGES) {
+        std::cerr << "Error: Checkpoint " << path << " was saved with a different memory or vector configuration" << std::endl;
+        return false;
+    }
+
+    ArchCheckpoint checkpoint;
+    for (int i = 0; i < 32; i++) checkpoint.Registers[i] = reader.Get32();
+    checkpoint.PC = reader.Get32();
+    checkpoint.CycleCount = reader.Get64();
+    for (int i = 0; i < 32; i++) checkpoint.FloatRegisters[i] = reader.Get64();
+    for (uint32_t* field : { &checkpoint.FCSR, &checkpoint.Privilege, &checkpoint.Satp, &checkpoint.MStatus, &checkpoint.MTvec,
+                             &checkpoint.MEpc, &checkpoint.MCause, &checkpoint.MTval, &checkpoint.MScratch, &checkpoint.VL, &checkpoint.VType,
+                             &checkpoint.VStart }) {
+        *field = reader.Get32();
+    }
+    checkpoint.bHalted = reader.Get32() != 0;
+    if (const uint8_t* vector_regs = reader.Take(vector_bytes)) {
+        checkpoint.VectorRegs.assign(vector_regs, vector_regs + vector_bytes);
+    }
+
+    // Validate the whole table up front, so pages can be decoded later without surprises
+    std::vector<PageRecord> records(page_count);
+    std::vector<uint32_t> pages(page_count);
+    std::vector<uint32_t> record_of_page(NUM_PAGES, UINT32_MAX);
+    bool valid = reader.bOk;
+    for (uint32_t i = 0; valid && i < page_count; i++) {
+        PageRecord& record = records[i];
+        record.Page = reader.Get32();
+        record.StoredSize = reader.Get32();
+        record.Offset = reader.Get64();
+        record.Checksum = reader.Get32();
+        valid = reader.bOk && record.Page < memory_size / PAGE_SIZE && record_of_page[record.Page] == UINT32_MAX &&
+                record.StoredSize > 0 && record.StoredSize <= PAGE_SIZE &&
+                record.Offset <= file->GetSize() && record.StoredSize <= file->GetSize() - record.Offset;
+        if (valid) {
+            record_of_page[record.Page] = i;
+            pages[i] = record.Page;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Error: Corrupt checkpoint " << path << std::endl;
+        return false;
+    }
+
+    cpu.RestoreCheckpoint(checkpoint);
+
+    // The loader keeps the file mapped for as long as the hart has pages pending. A page
+    // that fails its checksum is not filled, and the hart takes an access fault on it.
+    auto loader = [file, records = std::move(records), record_of_page = std::move(record_of_page)](uint32_t page, uint8_t* dest) {
+        const PageRecord& record = records[record_of_page[page]];
+        const uint8_t* stored = file->GetData() + record.Offset;
+        bool loaded = Crc32(stored, record.StoredSize) == record.Checksum;
+        if (loaded && record.StoredSize == PAGE_SIZE) {
+            std::memcpy(dest, stored, PAGE_SIZE);
+        } else if (loaded) {
+            loaded = DecompressPage(stored, record.StoredSize, dest);
+        }
+        if (!loaded) {
+            std::cerr << "Error: Corrupt checkpoint page " << std::hex << page << std::dec << std::endl;
+        }
+        return loaded;
+    };
+    cpu.ReplaceMemory(pages, loader, lazy);
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "RISCV_CPU.h"
+
+/**
+ * Self-contained hart snapshot on disk, for resuming long guest runs in a later
+ * process or on another machine.
+ *
+ * Unlike ArchCheckpoint, which only holds what differs from the loaded image,
+ * the file holds all of guest RAM, so no image is needed to restore it. Pages
+ * that are entirely zero are left out and the rest are LZ-compressed one page
+ * at a time. Loading maps the file and checks the header and page table only.
+ * By default it then fills a page of guest RAM only when the hart first touches
+ * it (RISCV_CPU::ReplaceMemory), so the untouched part of a large RAM is never
+ * read, copied or dirtied. Each page record carries a CRC-32 that is checked at
+ * that point; a damaged page is never filled, and the hart takes an access
+ * fault on it instead.
+ *
+ * File layout, all little endian:
+ *   Header   Magic, Version, PageSize, MemorySize, VectorBytes, PageCount (u32 each)
+ *   State    x0-x31, PC (u32), CycleCount (u64), f0-f31 (u64), FCSR, Privilege, satp,
+ *            mstatus, mtvec, mepc, mcause, mtval, mscratch, VL, VType, VStart,
+ *            Halted (u32), then VectorBytes of vector registers
+ *   Table    PageCount x { Page (u32), StoredSize (u32), Offset (u64), Checksum (u32) }
+ *   Data     The page records. StoredSize == PageSize means stored uncompressed.
+ */
+class RISCV_CheckpointFile {
+public:
+    // Writes the hart's architectural state and RAM to 'path' (replacing it).
+    // The hart must not be running.
+    static bool Save(RISCV_CPU& cpu, const std::string& path);
+
+    // Restores a file written by Save, or returns false without touching the hart if its
+    // header or page table is corrupt. The current image stays loaded, so Reset() afterwards
+    // still goes back to it. With 'lazy', the file stays mapped until every page has
+    // been touched (or LoadPendingPages / Reset is called).
+    static bool Load(RISCV_CPU& cpu, const std::string& path, bool lazy = true);
+
+private:
+    static const uint32_t FILE_MAGIC = 0x4B435652; // "RVCK"
+    static const uint32_t FILE_VERSION = 3;
+};
@@ -0,0 +1,536 @@
+#include "RISCV_Disassembler.h"
+
+namespace {
+
+// How the operands of an instruction are printed
+enum InstFormat : uint8_t {
+    FMT_R,        // rd, rs1, rs2
+    FMT_I,        // rd, rs1, imm
+    FMT_SHIFT,    // rd, rs1, shamt
+    FMT_LOAD,     // rd, imm(rs1)
+    FMT_STORE,    // rs2, imm(rs1)
+    FMT_BRANCH,   // rs1, rs2, offset
+    FMT_U_HEX,    // rd, 0xIMM
+    FMT_U_DEC,    // rd, imm
+    FMT_J,        // rd, offset
+    FMT_JALR,     // rd, imm(rs1)
+    FMT_FENCE,    // pred, succ
+    FMT_CSR,      // rd, csr, rs1
+    FMT_CSRI,     // rd, csr, uimm
+    FMT_AMO,      // rd, rs2, (rs1)
+    FMT_LR,       // rd, (rs1)
+    FMT_RS1_RS2,  // rs1, rs2
+    FMT_VSETVLI,  // rd, rs1, vtype
+    FMT_VSETIVLI, // rd, uimm, vtype
+    FMT_VMEM,     // vd, (rs1)
+    FMT_VMEM_STRIDED, // vd, (rs1), rs2
+    FMT_VV,       // vd, vs2, vs1
+    FMT_VX,       // vd, vs2, rs1
+    FMT_VI,       // vd, vs2, simm5
+    FMT_V_V,      // vd, vs1
+    FMT_V_X,      // vd, rs1
+    FMT_V_I,      // vd, simm5
+    FMT_X_V,      // rd, vs2
+    FMT_FLOAD,    // fd, imm(rs1)
+    FMT_FSTORE,   // fs2, imm(rs1)
+    FMT_F3,       // fd, fs1, fs2
+    FMT_F4,       // fd, fs1, fs2, fs3
+    FMT_F2,       // fd, fs1
+    FMT_X_F,      // rd, fs1
+    FMT_F_X,      // fd, rs1
+    FMT_X_FF,     // rd, fs1, fs2
+    FMT_NONE
+};
+
+struct InstPattern {
+    uint32_t Mask;
+    uint32_t Match;
+    const char* Name;
+    InstFormat Format;
+};
+
+// Field masks for building the table
+const uint32_t M_OPC   = 0x0000007F;
+const uint32_t M_F3    = 0x0000707F;
+const uint32_t M_F7    = 0xFE00707F;
+const uint32_t M_F5    = 0xF800707F; // AMOs (aq/rl ignored)
+const uint32_t M_ALL   = 0xFFFFFFFF;
+
+constexpr uint32_t F3(uint32_t f3, uint32_t opc) { return (f3 << 12) | opc; }
+constexpr uint32_t F7(uint32_t f7, uint32_t f3, uint32_t opc) { return (f7 << 25) | (f3 << 12) | opc; }
+constexpr uint32_t AMO(uint32_t f5) { return (f5 << 27) | (0x2 << 12) | 0x2F; }
+
+// Vector rows (vm, bit 25, is printed as ", v0.t" and not part of the match)
+const uint32_t M_V6    = 0xFC00707F; // funct6 + funct3
+const uint32_t M_V6_S2 = 0xFFF0707F; // ... and vs2 = 0 (vmv.v.*), vm = 1
+const uint32_t M_V6_S1 = 0xFC0FF07F; // ... and vs1 = 0 (vmv.x.s)
+const uint32_t M_VMEM  = 0xFDF0707F; // nf, mew, mop = unit stride, lumop = 0
+constexpr uint32_t V(uint32_t f6, uint32_t f3) { return (f6 << 26) | (f3 << 12) | 0x57; }
+constexpr uint32_t VM0(uint32_t f6, uint32_t f3) { return V(f6, f3); }                // vm = 0
+constexpr uint32_t VM1(uint32_t f6, uint32_t f3) { return V(f6, f3) | (1u << 25); }   // vm = 1
+constexpr uint32_t VMEM(uint32_t mop, uint32_t width, uint32_t opc) { return (mop << 26) | (width << 12) | opc; }
+
+// Floating point rows (the rm field, funct3, is not printed)
+const uint32_t M_FP    = 0xFE00007F; // funct7
+const uint32_t M_FP_S2 = 0xFFF0007F; // funct7 + rs2
+const uint32_t M_FP_F3 = 0xFE00707F; // funct7 + funct3
+const uint32_t M_FP_S2_F3 = 0xFFF0707F;
+const uint32_t M_R4    = 0x0600007F; // fmt + opcode
+constexpr uint32_t FP(uint32_t f7, uint32_t rs2 = 0, uint32_t f3 = 0) { return (f7 << 25) | (rs2 << 20) | (f3 << 12) | 0x53; }
+constexpr uint32_t R4(uint32_t fmt, uint32_t opc) { return (fmt << 25) | opc; }
+
+const InstPattern PATTERNS[] = {
+    // --- RV32I ---
+    { M_OPC, 0x37, "LUI",   FMT_U_HEX },
+    { M_OPC, 0x17, "AUIPC", FMT_U_DEC },
+    { M_OPC, 0x6F, "JAL",   FMT_J },
+    { M_F3, F3(0, 0x67), "JALR", FMT_JALR },
+
+    { M_F3, F3(0, 0x63), "BEQ",  FMT_BRANCH },
+    { M_F3, F3(1, 0x63), "BNE",  FMT_BRANCH },
+    { M_F3, F3(4, 0x63), "BLT",  FMT_BRANCH },
+    { M_F3, F3(5, 0x63), "BGE",  FMT_BRANCH },
+    { M_F3, F3(6, 0x63), "BLTU", FMT_BRANCH },
+    { M_F3, F3(7, 0x63), "BGEU", FMT_BRANCH },
+
+    { M_F3, F3(0, 0x03), "LB",  FMT_LOAD },
+    { M_F3, F3(1, 0x03), "LH",  FMT_LOAD },
+    { M_F3, F3(2, 0x03), "LW",  FMT_LOAD },
+    { M_F3, F3(4, 0x03), "LBU", FMT_LOAD },
+    { M_F3, F3(5, 0x03), "LHU", FMT_LOAD },
+
+    { M_F3, F3(0, 0x23), "SB", FMT_STORE },
+    { M_F3, F3(1, 0x23), "SH", FMT_STORE },
+    { M_F3, F3(2, 0x23), "SW", FMT_STORE },
+
+    { M_F3, F3(0, 0x13), "ADDI",  FMT_I },
+    { M_F3, F3(2, 0x13), "SLTI",  FMT_I },
+    { M_F3, F3(3, 0x13), "SLTIU", FMT_I },
+    { M_F3, F3(4, 0x13), "XORI",  FMT_I },
+    { M_F3, F3(6, 0x13), "ORI",   FMT_I },
+    { M_F3, F3(7, 0x13), "ANDI",  FMT_I },
+    { M_F7, F7(0x00, 1, 0x13), "SLLI", FMT_SHIFT },
+    { M_F7, F7(0x00, 5, 0x13), "SRLI", FMT_SHIFT },
+    { M_F7, F7(0x20, 5, 0x13), "SRAI", FMT_SHIFT },
+
+    { M_F7, F7(0x00, 0, 0x33), "ADD",  FMT_R },
+    { M_F7, F7(0x20, 0, 0x33), "SUB",  FMT_R },
+    { M_F7, F7(0x00, 1, 0x33), "SLL",  FMT_R },
+    { M_F7, F7(0x00, 2, 0x33), "SLT",  FMT_R },
+    { M_F7, F7(0x00, 3, 0x33), "SLTU", FMT_R },
+    { M_F7, F7(0x00, 4, 0x33), "XOR",  FMT_R },
+    { M_F7, F7(0x00, 5, 0x33), "SRL",  FMT_R },
+    { M_F7, F7(0x20, 5, 0x33), "SRA",  FMT_R },
+    { M_F7, F7(0x00, 6, 0x33), "OR",   FMT_R },
+    { M_F7, F7(0x00, 7, 0x33), "AND",  FMT_R },
+
+    { M_F3, F3(0, 0x0F), "FENCE",   FMT_FENCE },
+    { M_F3, F3(1, 0x0F), "FENCE.I", FMT_NONE },
+
+    // --- SYSTEM (exact encodings first, then Zicsr) ---
+    { M_ALL, 0x00000073, "ECALL",  FMT_NONE },
+    { M_ALL, 0x00100073, "EBREAK", FMT_NONE },
+    { M_ALL, 0x30200073, "MRET",   FMT_NONE },
+    { M_ALL, 0x10200073, "SRET",   FMT_NONE },
+    { M_ALL, 0x10500073, "WFI",    FMT_NONE },
+    { 0xFE007FFF, 0x12000073, "SFENCE.VMA", FMT_RS1_RS2 },
+    { M_F3, F3(1, 0x73), "CSRRW",  FMT_CSR },
+    { M_F3, F3(2, 0x73), "CSRRS",  FMT_CSR },
+    { M_F3, F3(3, 0x73), "CSRRC",  FMT_CSR },
+    { M_F3, F3(5, 0x73), "CSRRWI", FMT_CSRI },
+    { M_F3, F3(6, 0x73), "CSRRSI", FMT_CSRI },
+    { M_F3, F3(7, 0x73), "CSRRCI", FMT_CSRI },
+
+    // --- RV32A ---
+    { 0xF9F0707F, AMO(0x02), "LR.W", FMT_LR },
+    { M_F5, AMO(0x03), "SC.W",      FMT_AMO },
+    { M_F5, AMO(0x01), "AMOSWAP.W", FMT_AMO },
+    { M_F5, AMO(0x00), "AMOADD.W",  FMT_AMO },
+    { M_F5, AMO(0x04), "AMOXOR.W",  FMT_AMO },
+    { M_F5, AMO(0x0C), "AMOAND.W",  FMT_AMO },
+    { M_F5, AMO(0x08), "AMOOR.W",   FMT_AMO },
+    { M_F5, AMO(0x10), "AMOMIN.W",  FMT_AMO },
+    { M_F5, AMO(0x14), "AMOMAX.W",  FMT_AMO },
+    { M_F5, AMO(0x18), "AMOMINU.W", FMT_AMO },
+    { M_F5, AMO(0x1C), "AMOMAXU.W", FMT_AMO },
+
+    // --- RVV subset ---
+    { 0x8000707F, F3(7, 0x57), "VSETVLI",  FMT_VSETVLI },
+    { 0xC000707F, 0xC0007057,  "VSETIVLI", FMT_VSETIVLI },
+    { M_F7, F7(0x40, 7, 0x57), "VSETVL",   FMT_R },
+
+    { M_VMEM, VMEM(0, 0, 0x07), "VLE8.V",  FMT_VMEM },
+    { M_VMEM, VMEM(0, 5, 0x07), "VLE16.V", FMT_VMEM },
+    { M_VMEM, VMEM(0, 6, 0x07), "VLE32.V", FMT_VMEM },
+    { M_V6, VMEM(2, 0, 0x07), "VLSE8.V",  FMT_VMEM_STRIDED },
+    { M_V6, VMEM(2, 5, 0x07), "VLSE16.V", FMT_VMEM_STRIDED },
+    { M_V6, VMEM(2, 6, 0x07), "VLSE32.V", FMT_VMEM_STRIDED },
+    { M_VMEM, VMEM(0, 0, 0x27), "VSE8.V",  FMT_VMEM },
+    { M_VMEM, VMEM(0, 5, 0x27), "VSE16.V", FMT_VMEM },
+    { M_VMEM, VMEM(0, 6, 0x27), "VSE32.V", FMT_VMEM },
+    { M_V6, VMEM(2, 0, 0x27), "VSSE8.V",  FMT_VMEM_STRIDED },
+    { M_V6, VMEM(2, 5, 0x27), "VSSE16.V", FMT_VMEM_STRIDED },
+    { M_V6, VMEM(2, 6, 0x27), "VSSE32.V", FMT_VMEM_STRIDED },
+
+    { M_V6, V(0x00, 0), "VADD.VV",   FMT_VV },
+    { M_V6, V(0x00, 4), "VADD.VX",   FMT_VX },
+    { M_V6, V(0x00, 3), "VADD.VI",   FMT_VI },
+    { M_V6, V(0x02, 0), "VSUB.VV",   FMT_VV },
+    { M_V6, V(0x02, 4), "VSUB.VX",   FMT_VX },
+    { M_V6, V(0x03, 4), "VRSUB.VX",  FMT_VX },
+    { M_V6, V(0x03, 3), "VRSUB.VI",  FMT_VI },
+    { M_V6, V(0x09, 0), "VAND.VV",   FMT_VV },
+    { M_V6, V(0x09, 4), "VAND.VX",   FMT_VX },
+    { M_V6, V(0x09, 3), "VAND.VI",   FMT_VI },
+    { M_V6, V(0x0A, 0), "VOR.VV",    FMT_VV },
+    { M_V6, V(0x0A, 4), "VOR.VX",    FMT_VX },
+    { M_V6, V(0x0A, 3), "VOR.VI",    FMT_VI },
+    { M_V6, V(0x0B, 0), "VXOR.VV",   FMT_VV },
+    { M_V6, V(0x0B, 4), "VXOR.VX",   FMT_VX },
+    { M_V6, V(0x0B, 3), "VXOR.VI",   FMT_VI },
+
+    { M_V6_S2, VM1(0x17, 0), "VMV.V.V",    FMT_V_V },
+    { M_V6_S2, VM1(0x17, 4), "VMV.V.X",    FMT_V_X },
+    { M_V6_S2, VM1(0x17, 3), "VMV.V.I",    FMT_V_I },
+    { M_F7, VM0(0x17, 0), "VMERGE.VVM", FMT_VV },
+    { M_F7, VM0(0x17, 4), "VMERGE.VXM", FMT_VX },
+    { M_F7, VM0(0x17, 3), "VMERGE.VIM", FMT_VI },
+
+    { M_V6, V(0x18, 0), "VMSEQ.VV",  FMT_VV },
+    { M_V6, V(0x18, 4), "VMSEQ.VX",  FMT_VX },
+    { M_V6, V(0x18, 3), "VMSEQ.VI",  FMT_VI },
+    { M_V6, V(0x19, 0), "VMSNE.VV",  FMT_VV },
+    { M_V6, V(0x19, 4), "VMSNE.VX",  FMT_VX },
+    { M_V6, V(0x19, 3), "VMSNE.VI",  FMT_VI },
+    { M_V6, V(0x1A, 0), "VMSLTU.VV", FMT_VV },
+    { M_V6, V(0x1A, 4), "VMSLTU.VX", FMT_VX },
+    { M_V6, V(0x1B, 0), "VMSLT.VV",  FMT_VV },
+    { M_V6, V(0x1B, 4), "VMSLT.VX",  FMT_VX },
+    { M_V6, V(0x1C, 0), "VMSLEU.VV", FMT_VV },
+    { M_V6, V(0x1C, 4), "VMSLEU.VX", FMT_VX },
+    { M_V6, V(0x1C, 3), "VMSLEU.VI", FMT_VI },
+    { M_V6, V(0x1D, 0), "VMSLE.VV",  FMT_VV },
+    { M_V6, V(0x1D, 4), "VMSLE.VX",  FMT_VX },
+    { M_V6, V(0x1D, 3), "VMSLE.VI",  FMT_VI },
+    { M_V6, V(0x1E, 4), "VMSGTU.VX", FMT_VX },
+    { M_V6, V(0x1E, 3), "VMSGTU.VI", FMT_VI },
+    { M_V6, V(0x1F, 4), "VMSGT.VX",  FMT_VX },
+    { M_V6, V(0x1F, 3), "VMSGT.VI",  FMT_VI },
+
+    { M_V6, V(0x25, 2), "VMUL.VV",    FMT_VV },
+    { M_V6, V(0x25, 6), "VMUL.VX",    FMT_VX },
+    { M_V6, V(0x00, 2), "VREDSUM.VS", FMT_VV },
+    { M_V6_S1, V(0x10, 2), "VMV.X.S", FMT_X_V },
+    { M_V6_S2, VM1(0x10, 6), "VMV.S.X", FMT_V_X },
+
+    // --- RV32F/D ---
+    { M_F3, F3(2, 0x07), "FLW", FMT_FLOAD },
+    { M_F3, F3(3, 0x07), "FLD", FMT_FLOAD },
+    { M_F3, F3(2, 0x27), "FSW", FMT_FSTORE },
+    { M_F3, F3(3, 0x27), "FSD", FMT_FSTORE },
+
+    { M_R4, R4(0, 0x43), "FMADD.S",  FMT_F4 },
+    { M_R4, R4(0, 0x47), "FMSUB.S",  FMT_F4 },
+    { M_R4, R4(0, 0x4B), "FNMSUB.S", FMT_F4 },
+    { M_R4, R4(0, 0x4F), "FNMADD.S", FMT_F4 },
+    { M_R4, R4(1, 0x43), "FMADD.D",  FMT_F4 },
+    { M_R4, R4(1, 0x47), "FMSUB.D",  FMT_F4 },
+    { M_R4, R4(1, 0x4B), "FNMSUB.D", FMT_F4 },
+    { M_R4, R4(1, 0x4F), "FNMADD.D", FMT_F4 },
+
+    { M_FP, FP(0x00), "FADD.S", FMT_F3 },
+    { M_FP, FP(0x04), "FSUB.S", FMT_F3 },
+    { M_FP, FP(0x08), "FMUL.S", FMT_F3 },
+    { M_FP, FP(0x0C), "FDIV.S", FMT_F3 },
+    { M_FP_S2, FP(0x2C), "FSQRT.S", FMT_F2 },
+    { M_FP_F3, FP(0x10, 0, 0), "FSGNJ.S",  FMT_F3 },
+    { M_FP_F3, FP(0x10, 0, 1), "FSGNJN.S", FMT_F3 },
+    { M_FP_F3, FP(0x10, 0, 2), "FSGNJX.S", FMT_F3 },
+    { M_FP_F3, FP(0x14, 0, 0), "FMIN.S", FMT_F3 },
+    { M_FP_F3, FP(0x14, 0, 1), "FMAX.S", FMT_F3 },
+    { M_FP_F3, FP(0x50, 0, 2), "FEQ.S", FMT_X_FF },
+    { M_FP_F3, FP(0x50, 0, 1), "FLT.S", FMT_X_FF },
+    { M_FP_F3, FP(0x50, 0, 0), "FLE.S", FMT_X_FF },
+    { M_FP_S2, FP(0x60, 0), "FCVT.W.S",  FMT_X_F },
+    { M_FP_S2, FP(0x60, 1), "FCVT.WU.S", FMT_X_F },
+    { M_FP_S2, FP(0x68, 0), "FCVT.S.W",  FMT_F_X },
+    { M_FP_S2, FP(0x68, 1), "FCVT.S.WU", FMT_F_X },
+    { M_FP_S2_F3, FP(0x70, 0, 0), "FMV.X.W",  FMT_X_F },
+    { M_FP_S2_F3, FP(0x70, 0, 1), "FCLASS.S", FMT_X_F },
+    { M_FP_S2_F3, FP(0x78, 0, 0), "FMV.W.X",  FMT_F_X },
+
+    { M_FP, FP(0x01), "FADD.D", FMT_F3 },
+    { M_FP, FP(0x05), "FSUB.D", FMT_F3 },
+    { M_FP, FP(0x09), "FMUL.D", FMT_F3 },
+    { M_FP, FP(0x0D), "FDIV.D", FMT_F3 },
+    { M_FP_S2, FP(0x2D), "FSQRT.D", FMT_F2 },
+    { M_FP_F3, FP(0x11, 0, 0), "FSGNJ.D",  FMT_F3 },
+    { M_FP_F3, FP(0x11, 0, 1), "FSGNJN.D", FMT_F3 },
+    { M_FP_F3, FP(0x11, 0, 2), "FSGNJX.D", FMT_F3 },
+    { M_FP_F3, FP(0x15, 0, 0), "FMIN.D", FMT_F3 },
+    { M_FP_F3, FP(0x15, 0, 1), "FMAX.D", FMT_F3 },
+    { M_FP_S2, FP(0x20, 1), "FCVT.S.D", FMT_F2 },
+    { M_FP_S2, FP(0x21, 0), "FCVT.D.S", FMT_F2 },
+    { M_FP_F3, FP(0x51, 0, 2), "FEQ.D", FMT_X_FF },
+    { M_FP_F3, FP(0x51, 0, 1), "FLT.D", FMT_X_FF },
+    { M_FP_F3, FP(0x51, 0, 0), "FLE.D", FMT_X_FF },
+    { M_FP_S2, FP(0x61, 0), "FCVT.W.D",  FMT_X_F },
+    { M_FP_S2, FP(0x61, 1), "FCVT.WU.D", FMT_X_F },
+    { M_FP_S2, FP(0x69, 0), "FCVT.D.W",  FMT_F_X },
+    { M_FP_S2, FP(0x69, 1), "FCVT.D.WU", FMT_F_X },
+    { M_FP_S2_F3, FP(0x71, 0, 1), "FCLASS.D", FMT_X_F },
+};
+
+const size_t NUM_PATTERNS = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+
+/**
+ * Rows grouped by their 7-bit opcode, built once on first use.
+ * Bucket[op] is the range [Start, Start + Count) in Order.
+ */
+struct OpcodeBuckets {
+    uint16_t Start[128];
+    uint16_t Count[128];
+    uint16_t Order[NUM_PATTERNS];
+
+    OpcodeBuckets() {
+        size_t next = 0;
+        for (uint32_t op = 0; op < 128; op++) {
+            Start[op] = (uint16_t)next;
+            Count[op] = 0;
+            for (size_t i = 0; i < NUM_PATTERNS; i++) {
+                if ((PATTERNS[i].Match & M_OPC) == op) {
+                    Order[next++] = (uint16_t)i;
+                    Count[op]++;
+                }
+            }
+        }
+    }
+};
+
+const InstPattern* FindPattern(uint32_t inst) {
+    static const OpcodeBuckets buckets;
+
+    uint32_t op = inst & M_OPC;
+    for (uint32_t i = 0; i < buckets.Count[op]; i++) {
+        const InstPattern& p = PATTERNS[buckets.Order[buckets.Start[op] + i]];
+        if ((inst & p.Mask) == p.Match) return &p;
+    }
+    return nullptr;
+}
+
+const char* const NUMERIC_NAMES[32] = {
+    "x0",  "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",
+    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
+    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+    "x24", "x25", "x26", "x27", "x28", "x29", "x30", "x31"
+};
+
+const char* const FLOAT_NUMERIC_NAMES[32] = {
+    "f0",  "f1",  "f2",  "f3",  "f4",  "f5",  "f6",  "f7",
+    "f8",  "f9",  "f10", "f11", "f12", "f13", "f14", "f15",
+    "f16", "f17", "f18", "f19", "f20", "f21", "f22", "f23",
+    "f24", "f25", "f26", "f27", "f28", "f29", "f30", "f31"
+};
+
+const char* const FLOAT_ABI_NAMES[32] = {
+    "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+    "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+    "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+    "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"
+};
+
+const char* const ABI_NAMES[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0",   "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6",   "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8",   "s9", "s10", "s11", "t3", "t4", "t5", "t6"
+};
+
+/**
+ * Bounded character writer. Silently truncates and always leaves room for the NUL.
+ */
+struct TextWriter {
+    char* Pos;
+    char* End; // One before the real end, reserved for the terminator
+
+    TextWriter(char* buffer, size_t size) : Pos(buffer), End(buffer + (size ? size - 1 : 0)) {}
+
+    void Char(char c) { if (Pos < End) *Pos++ = c; }
+    void Str(const char* s) { while (*s && Pos < End) *Pos++ = *s++; }
+
+    void Dec(int32_t value) {
+        uint32_t magnitude = (uint32_t)value;
+        if (value < 0) {
+            Char('-');
+            magnitude = 0u - magnitude;
+        }
+        char digits[10];
+        int count = 0;
+        do {
+            digits[count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        while (count) Char(digits[--count]);
+    }
+
+    void Hex(uint32_t value, int minDigits) {
+        static const char HEX[] = "0123456789ABCDEF";
+        char digits[8];
+        int count = 0;
+        do {
+            digits[count++] = HEX[value & 0xF];
+            value >>= 4;
+        } while (value || count < minDigits);
+        while (count) Char(digits[--count]);
+    }
+
+    void Reg(uint32_t reg, bool abi) { Str(abi ? ABI_NAMES[reg] : NUMERIC_NAMES[reg]); }
+    void VReg(uint32_t reg) { Char('v'); Dec((int32_t)reg); }
+    void FReg(uint32_t reg, bool abi) { Str(abi ? FLOAT_ABI_NAMES[reg] : FLOAT_NUMERIC_NAMES[reg]); }
+    void Sep() { Char(','); Char(' '); }
+    void Terminate() { *Pos = '\0'; }
+};
+
+// --- Immediate extraction (same bit layouts as RISCV_CPU::GenerateImmediate) ---
+int32_t ImmI(uint32_t inst) { return (int32_t)inst >> 20; }
+int32_t ImmS(uint32_t inst) { return ((int32_t)(inst & 0xFE000000) >> 20) | ((inst >> 7) & 0x1F); }
+int32_t ImmB(uint32_t inst) {
+    return ((int32_t)(inst & 0x80000000) >> 19) | ((inst & 0x80) << 4) | ((inst >> 20) & 0x7E0) | ((inst >> 7) & 0x1E);
+}
+int32_t ImmV5(uint32_t inst) { return (int32_t)(inst << 12) >> 27; } // simm5 in the rs1 field
+int32_t ImmJ(uint32_t inst) {
+    return ((int32_t)(inst & 0x80000000) >> 11) | (inst & 0xFF000) | ((inst >> 9) & 0x800) | ((inst >> 20) & 0x7FE);
+}
+
+void WriteFenceSet(TextWriter& w, uint32_t bits) {
+    if (bits & 0x8) w.Char('i');
+    if (bits & 0x4) w.Char('o');
+    if (bits & 0x2) w.Char('r');
+    if (bits & 0x1) w.Char('w');
+    if (!bits) w.Char('0');
+}
+
+void WriteInstruction(TextWriter& w, uint32_t inst, bool abi) {
+    const InstPattern* p = FindPattern(inst);
+    if (!p) {
+        w.Str("UNKNOWN 0x");
+        w.Hex(inst, 8);
+        return;
+    }
+
+    uint32_t rd  = (inst >> 7) & 0x1F;
+    uint32_t rs1 = (inst >> 15) & 0x1F;
+    uint32_t rs2 = (inst >> 20) & 0x1F;
+
+    w.Str(p->Name);
+    if (p->Format == FMT_NONE) return;
+    w.Char(' ');
+
+    switch (p->Format) {
+        case FMT_R:      w.Reg(rd, abi); w.Sep(); w.Reg(rs1, abi); w.Sep(); w.Reg(rs2, abi); break;
+        case FMT_I:      w.Reg(rd, abi); w.Sep(); w.Reg(rs1, abi); w.Sep(); w.Dec(ImmI(inst)); break;
+        case FMT_SHIFT:  w.Reg(rd, abi); w.Sep(); w.Reg(rs1, abi); w.Sep(); w.Dec((int32_t)rs2); break;
+        case FMT_LOAD:   w.Reg(rd, abi); w.Sep(); w.Dec(ImmI(inst)); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_JALR:   w.Reg(rd, abi); w.Sep(); w.Dec(ImmI(inst)); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_STORE:  w.Reg(rs2, abi); w.Sep(); w.Dec(ImmS(inst)); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_BRANCH: w.Reg(rs1, abi); w.Sep(); w.Reg(rs2, abi); w.Sep(); w.Dec(ImmB(inst)); break;
+        case FMT_U_HEX:  w.Reg(rd, abi); w.Sep(); w.Str("0x"); w.Hex(inst & 0xFFFFF000, 1); break;
+        case FMT_U_DEC:  w.Reg(rd, abi); w.Sep(); w.Dec((int32_t)(inst & 0xFFFFF000)); break;
+        case FMT_J:      w.Reg(rd, abi); w.Sep(); w.Dec(ImmJ(inst)); break;
+        case FMT_FENCE:  WriteFenceSet(w, (inst >> 24) & 0xF); w.Sep(); WriteFenceSet(w, (inst >> 20) & 0xF); break;
+        case FMT_CSR:    w.Reg(rd, abi); w.Sep(); w.Str("0x"); w.Hex(inst >> 20, 3); w.Sep(); w.Reg(rs1, abi); break;
+        case FMT_CSRI:   w.Reg(rd, abi); w.Sep(); w.Str("0x"); w.Hex(inst >> 20, 3); w.Sep(); w.Dec((int32_t)rs1); break;
+        case FMT_AMO:    w.Reg(rd, abi); w.Sep(); w.Reg(rs2, abi); w.Sep(); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_LR:     w.Reg(rd, abi); w.Sep(); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_RS1_RS2: w.Reg(rs1, abi); w.Sep(); w.Reg(rs2, abi); break;
+        case FMT_VSETVLI:  w.Reg(rd, abi); w.Sep(); w.Reg(rs1, abi); w.Sep(); w.Str("0x"); w.Hex((inst >> 20) & 0x7FF, 1); break;
+        case FMT_VSETIVLI: w.Reg(rd, abi); w.Sep(); w.Dec((int32_t)rs1); w.Sep(); w.Str("0x"); w.Hex((inst >> 20) & 0x3FF, 1); break;
+        case FMT_VMEM:     w.VReg(rd); w.Sep(); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_VMEM_STRIDED: w.VReg(rd); w.Sep(); w.Char('('); w.Reg(rs1, abi); w.Char(')'); w.Sep(); w.Reg(rs2, abi); break;
+        case FMT_VV:       w.VReg(rd); w.Sep(); w.VReg(rs2); w.Sep(); w.VReg(rs1); break;
+        case FMT_VX:       w.VReg(rd); w.Sep(); w.VReg(rs2); w.Sep(); w.Reg(rs1, abi); break;
+        case FMT_VI:       w.VReg(rd); w.Sep(); w.VReg(rs2); w.Sep(); w.Dec(ImmV5(inst)); break;
+        case FMT_V_V:      w.VReg(rd); w.Sep(); w.VReg(rs1); break;
+        case FMT_V_X:      w.VReg(rd); w.Sep(); w.Reg(rs1, abi); break;
+        case FMT_V_I:      w.VReg(rd); w.Sep(); w.Dec(ImmV5(inst)); break;
+        case FMT_X_V:      w.Reg(rd, abi); w.Sep(); w.VReg(rs2); break;
+        case FMT_FLOAD:    w.FReg(rd, abi); w.Sep(); w.Dec(ImmI(inst)); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_FSTORE:   w.FReg(rs2, abi); w.Sep(); w.Dec(ImmS(inst)); w.Char('('); w.Reg(rs1, abi); w.Char(')'); break;
+        case FMT_F3:       w.FReg(rd, abi); w.Sep(); w.FReg(rs1, abi); w.Sep(); w.FReg(rs2, abi); break;
+        case FMT_F4:       w.FReg(rd, abi); w.Sep(); w.FReg(rs1, abi); w.Sep(); w.FReg(rs2, abi); w.Sep(); w.FReg(inst >> 27, abi); break;
+        case FMT_F2:       w.FReg(rd, abi); w.Sep(); w.FReg(rs1, abi); break;
+        case FMT_X_F:      w.Reg(rd, abi); w.Sep(); w.FReg(rs1, abi); break;
+        case FMT_F_X:      w.FReg(rd, abi); w.Sep(); w.Reg(rs1, abi); break;
+        case FMT_X_FF:     w.Reg(rd, abi); w.Sep(); w.FReg(rs1, abi); w.Sep(); w.FReg(rs2, abi); break;
+        default: break;
+    }
+
+    // Vector mask operand (vm = 0): vmerge takes v0 as a data operand, the rest are masked by it
+    bool is_vector = p->Format >= FMT_VMEM && p->Format <= FMT_X_V;
+    if (is_vector && !((inst >> 25) & 1)) {
+        w.Sep();
+        w.Str((inst >> 26) == 0x17 && (inst & M_OPC) == 0x57 ? "v0" : "v0.t");
+    }
+}
+
+// "<addr>: <word>  <text>\n"
+void WriteListingLine(TextWriter& w, uint32_t addr, uint32_t inst, bool abi) {
+    w.Hex(addr, 8);
+    w.Char(':');
+    w.Char(' ');
+    w.Hex(inst, 8);
+    w.Char(' ');
+    w.Char(' ');
+    WriteInstruction(w, inst, abi);
+    w.Char('\n');
+}
+
+} // namespace
+
+size_t RISCV_Disassembler::Disassemble(uint32_t inst, char* buffer, size_t bufferSize, bool abiNames) {
+    if (bufferSize == 0) return 0;
+
+    TextWriter w(buffer, bufferSize);
+    WriteInstruction(w, inst, abiNames);
+    w.Terminate();
+    return w.Pos - buffer;
+}
+
+size_t RISCV_Disassembler::ListImage(const uint8_t* code, size_t codeSize, uint32_t baseAddr,
+                                     char* out, size_t outSize, bool abiNames, size_t* wordsDone) {
+    TextWriter w(out, outSize);
+    size_t words = codeSize / 4;
+    size_t done = 0;
+
+    // Only start a line if a full one is guaranteed to fit
+    while (done < words && (size_t)(w.End - w.Pos) >= MAX_LINE) {
+        const uint8_t* bytes = code + done * 4;
+        uint32_t inst = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        WriteListingLine(w, baseAddr + (uint32_t)(done * 4), inst, abiNames);
+        done++;
+    }
+
+    if (outSize) w.Terminate();
+    if (wordsDone) *wordsDone = done;
+    return w.Pos - out;
+}
+
+size_t RISCV_Disassembler::ListTrace(const uint32_t* pcs, const uint32_t* insts, size_t count,
+                                     char* out, size_t outSize, bool abiNames, size_t* entriesDone) {
+    TextWriter w(out, outSize);
+    size_t done = 0;
+
+    while (done < count && (size_t)(w.End - w.Pos) >= MAX_LINE) {
+        WriteListingLine(w, pcs[done], insts[done], abiNames);
+        done++;
+    }
+
+    if (outSize) w.Terminate();
+    if (entriesDone) *entriesDone = done;
+    return w.Pos - out;
+}
+
+const char* RISCV_Disassembler::RegisterName(uint32_t reg, bool abiNames) {
+    reg &= 0x1F;
+    return abiNames ? ABI_NAMES[reg] : NUMERIC_NAMES[reg];
+}
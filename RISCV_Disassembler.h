@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Table-driven RV32 disassembler that writes into caller-provided buffers.
+ *
+ * Every instruction is described by one row (mask, match, mnemonic, operand
+ * format) and rows are bucketed by opcode, so decoding is a short scan and
+ * formatting is a few character copies - no allocation, no printf.
+ * Covers RV32I, Zicsr, Zifencei, RV32A, RV32F/D, the RVV subset we execute and
+ * the privileged instructions.
+ *
+ * Output follows the style the visualizer has always shown, e.g.
+ * "ADDI x1, x0, 1", "SW x5, 8(x2)", "BEQ x1, x2, -12" (branch/jump offsets
+ * are relative to the instruction).
+ */
+class RISCV_Disassembler {
+public:
+    // Disassemble one instruction. Always NUL-terminates (if bufferSize > 0).
+    // Returns the number of characters written, excluding the terminator.
+    static size_t Disassemble(uint32_t inst, char* buffer, size_t bufferSize, bool abiNames = false);
+
+    // Bulk listing of a code image, one "<addr>: <word>  <text>\n" line per word.
+    // Stops at a line boundary if 'out' fills up; 'wordsDone' tells how far it got,
+    // so the caller can flush the buffer and continue from there.
+    static size_t ListImage(const uint8_t* code, size_t codeSize, uint32_t baseAddr,
+                            char* out, size_t outSize, bool abiNames = false, size_t* wordsDone = nullptr);
+
+    // Bulk listing of an execution trace (parallel arrays of PCs and instruction words)
+    static size_t ListTrace(const uint32_t* pcs, const uint32_t* insts, size_t count,
+                            char* out, size_t outSize, bool abiNames = false, size_t* entriesDone = nullptr);
+
+    // "x5" or "t0"
+    static const char* RegisterName(uint32_t reg, bool abiNames);
+
+    // Longest line ListImage/ListTrace can produce (including the newline)
+    static const size_t MAX_LINE = 64;
+};
@@ -0,0 +1,293 @@
+#include "RISCV_EventScheduler.h"
+#include <algorithm>
+
+RISCV_EventScheduler::RISCV_EventScheduler() {
+    FreeList = NONE;
+    Reset();
+}
+
+void RISCV_EventScheduler::Reset() {
+    // Return every node to the pool (their memory is kept for reuse)
+    FreeList = NONE;
+    for (uint32_t i = 0; i < Pool.size(); i++) {
+        Pool[i].Fn = nullptr;
+        Pool[i].Generation++;
+        Pool[i].Next = FreeList;
+        FreeList = i;
+    }
+
+    for (int level = 0; level < LEVELS; level++) {
+        for (uint32_t slot = 0; slot < SLOTS; slot++) {
+            Wheel[level][slot] = EventList();
+        }
+        for (uint32_t word = 0; word < SLOTS / 64; word++) {
+            Occupied[level][word] = 0;
+        }
+    }
+    Overflow = EventList();
+
+    Pending = 0;
+    Now = 0;
+    NextDue = UINT64_MAX;
+}
+
+/*
+    Event Pool
+*/
+
+uint32_t RISCV_EventScheduler::AllocNode() {
+    if (FreeList == NONE) {
+        Pool.push_back({ 0, NONE, 0, false, nullptr });
+        return (uint32_t)Pool.size() - 1;
+    }
+
+    uint32_t index = FreeList;
+    FreeList = Pool[index].Next;
+    return index;
+}
+
+void RISCV_EventScheduler::ReleaseNode(uint32_t index) {
+    EventNode& node = Pool[index];
+    node.Fn = nullptr;
+    node.Generation++;
+    node.Next = FreeList;
+    FreeList = index;
+}
+
+void RISCV_EventScheduler::Append(EventList& list, uint32_t index) {
+    Pool[index].Next = NONE;
+    if (list.Tail == NONE) {
+        list.Head = index;
+    } else {
+        Pool[list.Tail].Next = index;
+    }
+    list.Tail = index;
+}
+
+/*
+    Timing Wheel
+*/
+
+void RISCV_EventScheduler::Insert(uint32_t index) {
+    uint64_t cycle = Pool[index].Cycle;
+
+    // Lowest level whose current block (relative to Now) contains the event
+    for (int level = 0; level < LEVELS; level++) {
+        int shift = SLOT_BITS * (level + 1);
+        if ((cycle >> shift) == (Now >> shift)) {
+            uint32_t slot = (cycle >> (SLOT_BITS * level)) & (SLOTS - 1);
+            Append(Wheel[level][slot], index);
+            Occupied[level][slot / 64] |= 1ull << (slot % 64);
+            return;
+        }
+    }
+    Append(Overflow, index);
+}
+
+int RISCV_EventScheduler::FindSlot(int level, uint32_t from) const {
+    // First occupied slot at or after 'from' (-1 if none)
+    for (uint32_t word = from / 64; word < SLOTS / 64; word++) {
+        uint64_t bits = Occupied[level][word];
+        if (word == from / 64) {
+            bits &= ~0ull << (from % 64);
+        }
+        if (bits) {
+            int bit = 0;
+            while (!((bits >> bit) & 1)) bit++;
+            return (int)(word * 64 + bit);
+        }
+    }
+    return -1;
+}
+
+void RISCV_EventScheduler::Cascade(int level, uint32_t slot) {
+    // Now has just entered this slot's block: spread its events over the lower levels
+    EventList list = Wheel[level][slot];
+    Wheel[level][slot] = EventList();
+    Occupied[level][slot / 64] &= ~(1ull << (slot % 64));
+
+    for (uint32_t index = list.Head; index != NONE; ) {
+        uint32_t next = Pool[index].Next;
+        Insert(index);
+        index = next;
+    }
+}
+
+void RISCV_EventScheduler::RefileOverflow() {
+    EventList list = Overflow;
+    Overflow = EventList();
+
+    for (uint32_t index = list.Head; index != NONE; ) {
+        uint32_t next = Pool[index].Next;
+        Insert(index);
+        index = next;
+    }
+}
+
+void RISCV_EventScheduler::FireSlot(uint32_t slot, uint64_t& fired) {
+    // Callbacks may schedule more events for this same cycle; loop until the slot stays empty
+    while (Wheel[0][slot].Head != NONE) {
+        EventList list = Wheel[0][slot];
+        Wheel[0][slot] = EventList();
+        Occupied[0][slot / 64] &= ~(1ull << (slot % 64));
+
+        for (uint32_t index = list.Head; index != NONE; ) {
+            uint32_t next = Pool[index].Next;
+            Callback fn = std::move(Pool[index].Fn);
+            bool cancelled = Pool[index].bCancelled;
+            ReleaseNode(index);
+            Pending--;
+
+            if (!cancelled) {
+                fn(Now);
+                fired++;
+            }
+            index = next;
+        }
+    }
+}
+
+uint64_t RISCV_EventScheduler::RunUntil(uint64_t limit) {
+    uint64_t fired = 0;
+
+    while (Pending > 0) {
+        // 1. Something left in the current 256-cycle block?
+        int slot = FindSlot(0, Now & (SLOTS - 1));
+        if (slot >= 0) {
+            uint64_t cycle = (Now & ~(uint64_t)(SLOTS - 1)) | (uint32_t)slot;
+            if (cycle > limit) break;
+
+            Now = cycle;
+            FireSlot(slot, fired);
+            continue;
+        }
+
+        // 2. Otherwise skip straight to the next occupied block on a higher level
+        bool cascaded = false;
+        bool past_limit = false;
+        for (int level = 1; level < LEVELS && !cascaded && !past_limit; level++) {
+            int shift = SLOT_BITS * level;
+            uint32_t current = (Now >> shift) & (SLOTS - 1);
+            int next = (current + 1 < SLOTS) ? FindSlot(level, current + 1) : -1;
+            if (next < 0) continue;
+
+            uint64_t block_mask = (1ull << (shift + SLOT_BITS)) - 1;
+            uint64_t block_start = (Now & ~block_mask) | ((uint64_t)next << shift);
+            if (block_start > limit) {
+                past_limit = true;
+                break;
+            }
+
+            Now = block_start;
+            Cascade(level, next);
+            cascaded = true;
+        }
+        if (cascaded) continue;
+        if (past_limit) break;
+
+        // 3. Only far-future events remain: jump to the earliest and re-file them all
+        uint64_t earliest = UINT64_MAX;
+        for (uint32_t index = Overflow.Head; index != NONE; index = Pool[index].Next) {
+            earliest = std::min(earliest, Pool[index].Cycle);
+        }
+        if (earliest == UINT64_MAX || earliest > limit) break;
+
+        Now = earliest;
+        RefileOverflow();
+    }
+
+    // Idle time up to the limit is skipped in one step
+    if (limit > Now && limit != UINT64_MAX) {
+        bool new_epoch = (limit >> (SLOT_BITS * LEVELS)) != (Now >> (SLOT_BITS * LEVELS));
+        Now = limit;
+        if (new_epoch) {
+            RefileOverflow(); // Far-future events may now fit on the wheel
+        }
+    }
+    UpdateNextDue();
+    return fired;
+}
+
+bool RISCV_EventScheduler::RunNext() {
+    uint64_t next = GetNextEventCycle();
+    if (next == UINT64_MAX) return false;
+
+    RunUntil(next);
+    return true;
+}
+
+uint64_t RISCV_EventScheduler::GetNextEventCycle() const {
+    if (Pending == 0) return UINT64_MAX;
+
+    // Level 0 slots map to exact cycles
+    int slot = FindSlot(0, Now & (SLOTS - 1));
+    if (slot >= 0) {
+        return (Now & ~(uint64_t)(SLOTS - 1)) | (uint32_t)slot;
+    }
+
+    // Higher levels: the earliest event inside the first occupied block
+    for (int level = 1; level < LEVELS; level++) {
+        uint32_t current = (Now >> (SLOT_BITS * level)) & (SLOTS - 1);
+        int next = (current + 1 < SLOTS) ? FindSlot(level, current + 1) : -1;
+        if (next < 0) continue;
+
+        uint64_t earliest = UINT64_MAX;
+        for (uint32_t index = Wheel[level][next].Head; index != NONE; index = Pool[index].Next) {
+            earliest = std::min(earliest, Pool[index].Cycle);
+        }
+        return earliest;
+    }
+
+    uint64_t earliest = UINT64_MAX;
+    for (uint32_t index = Overflow.Head; index != NONE; index = Pool[index].Next) {
+        earliest = std::min(earliest, Pool[index].Cycle);
+    }
+    return earliest;
+}
+
+void RISCV_EventScheduler::UpdateNextDue() {
+    NextDue = GetNextEventCycle();
+}
+
+/*
+    Public Scheduling API
+*/
+
+RISCV_EventScheduler::EventHandle RISCV_EventScheduler::ScheduleAt(uint64_t cycle, Callback callback) {
+    uint32_t index = AllocNode();
+    EventNode& node = Pool[index];
+    node.Cycle = std::max(cycle, Now);
+    node.bCancelled = false;
+    node.Fn = std::move(callback);
+
+    Insert(index);
+    Pending++;
+    NextDue = std::min(NextDue, node.Cycle);
+
+    return ((uint64_t)node.Generation << 32) | index;
+}
+
+RISCV_EventScheduler::EventHandle RISCV_EventScheduler::ScheduleIn(uint64_t delay, Callback callback) {
+    return ScheduleAt(Now + delay, std::move(callback));
+}
+
+bool RISCV_EventScheduler::Cancel(EventHandle handle) {
+    uint32_t index = (uint32_t)handle;
+    uint32_t generation = (uint32_t)(handle >> 32);
+    if (index >= Pool.size() || Pool[index].Generation != generation || Pool[index].bCancelled) {
+        return false; // Already fired or cancelled
+    }
+
+    // The node stays on its list and is dropped when its cycle comes up
+    Pool[index].bCancelled = true;
+    Pool[index].Fn = nullptr;
+    return true;
+}
+
+uint64_t RISCV_EventScheduler::GetNow() const {
+    return Now;
+}
+
+size_t RISCV_EventScheduler::GetPendingCount() const {
+    return Pending;
+}
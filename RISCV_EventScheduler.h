@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Discrete-event simulation kernel built on a hierarchical timing wheel.
+ *
+ * Components schedule callbacks at future cycles instead of being ticked
+ * every cycle. Time only ever jumps from one pending event to the next, so
+ * idle stretches (e.g. a 300-cycle DRAM access) cost nothing to simulate.
+ *
+ * Layout: 4 levels of 256 slots. Level 0 holds events in the current
+ * 256-cycle block one cycle per slot, level 1 holds 256-cycle blocks, and so
+ * on up to 2^32 cycles ahead; anything further waits in an overflow list.
+ * A 256-bit occupancy bitmap per level finds the next non-empty slot in a
+ * few instructions. Event nodes come from a pool with a free list, so
+ * scheduling does not allocate once the pool has warmed up.
+ */
+class RISCV_EventScheduler {
+public:
+    using Callback = std::function<void(uint64_t cycle)>;
+
+    // Identifies a scheduled event (for Cancel). Stays valid until the event fires.
+    typedef uint64_t EventHandle;
+
+    RISCV_EventScheduler();
+
+    // Cycles in the past are treated as "now"
+    EventHandle ScheduleAt(uint64_t cycle, Callback callback);
+    EventHandle ScheduleIn(uint64_t delay, Callback callback);
+    bool Cancel(EventHandle handle);
+
+    // Fire every event due at or before 'limit' (in cycle order), then move time to 'limit'.
+    // Returns the number of callbacks run.
+    uint64_t RunUntil(uint64_t limit);
+
+    // Jump to the next pending event and fire everything due at that cycle
+    bool RunNext();
+
+    // Earliest pending event (UINT64_MAX if there is none)
+    uint64_t GetNextEventCycle() const;
+
+    // Cheap lower bound on the next event, for polling from a hot loop
+    uint64_t PeekNextDue() const { return NextDue; }
+
+    uint64_t GetNow() const;
+    size_t GetPendingCount() const;
+    void Reset();
+
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const uint32_t SLOTS = 1u << SLOT_BITS;
+    static const uint32_t NONE = 0xFFFFFFFF;
+
+    // Pooled event node, linked by index into the pool
+    struct EventNode {
+        uint64_t Cycle;
+        uint32_t Next;
+        uint32_t Generation; // Bumped on release, so stale handles can be detected
+        bool bCancelled;
+        Callback Fn;
+    };
+
+    // FIFO list of nodes (events due in the same cycle fire in scheduling order)
+    struct EventList {
+        uint32_t Head = NONE;
+        uint32_t Tail = NONE;
+    };
+
+    uint32_t AllocNode();
+    void ReleaseNode(uint32_t index);
+    void Append(EventList& list, uint32_t index);
+    void Insert(uint32_t index);
+    void Cascade(int level, uint32_t slot);
+    void RefileOverflow();
+    void FireSlot(uint32_t slot, uint64_t& fired);
+    int FindSlot(int level, uint32_t from) const;
+    void UpdateNextDue();
+
+    std::vector<EventNode> Pool;
+    uint32_t FreeList;
+    size_t Pending;
+
+    EventList Wheel[LEVELS][SLOTS];
+    uint64_t Occupied[LEVELS][SLOTS / 64];
+    EventList Overflow;
+
+    uint64_t Now;
+    uint64_t NextDue;
+};
@@ -0,0 +1,151 @@
+#include "RISCV_HartGroup.h"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <thread>
+
+namespace {
+    // Debugger stops end the group's run at once. A halted hart just sits out
+    // the remaining quanta until every hart has halted.
+    bool IsDebugStop(const StopInfo& stop) {
+        return stop.Reason == StopReason::Breakpoint || stop.Reason == StopReason::Watchpoint;
+    }
+}
+
+RISCV_HartGroup::RISCV_HartGroup(uint32_t numHarts, uint64_t quantum) {
+    Memory = std::make_shared<GuestMemory>(RISCV_CPU::MEMORY_SIZE, RISCV_CPU::NUM_PAGES);
+    Quantum = std::max<uint64_t>(quantum, 1);
+    bDeterministic = false;
+    Stop = StopInfo{};
+    StoppedHart = 0;
+
+    numHarts = std::max(numHarts, 1u);
+    Uart = std::make_shared<RISCV_UART>();
+    Clint = std::make_shared<RISCV_CLINT>(numHarts);
+    for (uint32_t i = 0; i < numHarts; i++) {
+        Harts.push_back(std::make_unique<RISCV_CPU>(Memory, i, Uart, Clint));
+
+        // Another hart's store can end a loop that looks idle to this one
+        if (numHarts > 1) {
+            Harts.back()->EnableIdleSkip(false);
+        }
+    }
+}
+
+void RISCV_HartGroup::LoadMemory(const std::vector<uint8_t>& programData, uint32_t startAddr) {
+    // The image lives in the shared memory, so loading through one hart is enough
+    Harts[0]->LoadMemory(programData, startAddr);
+}
+
+void RISCV_HartGroup::Reset() {
+    for (std::unique_ptr<RISCV_CPU>& hart : Harts) {
+        hart->Reset();
+    }
+}
+
+uint64_t RISCV_HartGroup::RunFor(uint64_t instructionsPerHart) {
+    Stop = StopInfo{};
+    StoppedHart = 0;
+    if (bDeterministic || Harts.size() == 1) {
+        return RunDeterministic(instructionsPerHart);
+    }
+    return RunParallel(instructionsPerHart);
+}
+
+uint64_t RISCV_HartGroup::RunDeterministic(uint64_t instructionsPerHart) {
+    uint64_t total = 0;
+
+    // Same quantum schedule as the parallel mode, but one hart at a time in a fixed order
+    for (uint64_t done = 0; done < instructionsPerHart; done += Quantum) {
+        uint64_t slice = std::min(Quantum, instructionsPerHart - done);
+        for (uint32_t i = 0; i < Harts.size(); i++) {
+            total += Harts[i]->RunFor(slice);
+            if (IsDebugStop(Harts[i]->GetStopInfo()) || (Harts[i]->IsHalted() && AllHalted())) {
+                Stop = Harts[i]->GetStopInfo();
+                StoppedHart = i;
+                return total;
+            }
+        }
+    }
+    return total;
+}
+
+uint64_t RISCV_HartGroup::RunParallel(uint64_t instructionsPerHart) {
+    std::atomic<uint64_t> total(0);
+
+    // The first hart to stop claims the group's stop. Whether to go on is decided once
+    // per quantum, while every hart waits at the barrier, so they all leave together.
+    std::atomic<bool> stopped(false);
+    std::atomic<uint32_t> last_halted(0);
+    bool end_run = false;
+    auto on_quantum_end = [&]() noexcept {
+        if (!stopped.load() && AllHalted()) {
+            stopped.store(true);
+            StoppedHart = last_halted.load();
+            Stop = Harts[StoppedHart]->GetStopInfo();
+        }
+        end_run = stopped.load();
+    };
+
+    // All harts meet here at the end of every quantum
+    std::barrier quantum_barrier((std::ptrdiff_t)Harts.size(), on_quantum_end);
+
+    auto hart_main = [&](uint32_t index) {
+        RISCV_CPU* hart = Harts[index].get();
+        uint64_t executed = 0;
+        for (uint64_t done = 0; done < instructionsPerHart; done += Quantum) {
+            uint64_t slice = std::min(Quantum, instructionsPerHart - done);
+            uint64_t ran = hart->RunFor(slice);
+            executed += ran;
+            if (IsDebugStop(hart->GetStopInfo()) && !stopped.exchange(true)) {
+                Stop = hart->GetStopInfo();
+                StoppedHart = index;
+            }
+            if (ran > 0 && hart->IsHalted()) last_halted.store(index);
+            quantum_barrier.arrive_and_wait();
+            if (end_run) break;
+        }
+        total += executed;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(Harts.size());
+    for (uint32_t i = 0; i < Harts.size(); i++) {
+        threads.emplace_back(hart_main, i);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return total.load();
+}
+
+bool RISCV_HartGroup::AllHalted() const {
+    for (const std::unique_ptr<RISCV_CPU>& hart : Harts) {
+        if (!hart->IsHalted()) return false;
+    }
+    return true;
+}
+
+void RISCV_HartGroup::SetQuantum(uint64_t quantum) {
+    Quantum = std::max<uint64_t>(quantum, 1);
+}
+
+void RISCV_HartGroup::SetDeterministic(bool deterministic) {
+    bDeterministic = deterministic;
+}
+
+const StopInfo& RISCV_HartGroup::GetStopInfo() const {
+    return Stop;
+}
+
+uint32_t RISCV_HartGroup::GetStoppedHart() const {
+    return StoppedHart;
+}
+
+RISCV_CPU& RISCV_HartGroup::GetHart(uint32_t index) {
+    return *Harts[index];
+}
+
+uint32_t RISCV_HartGroup::GetNumHarts() const {
+    return (uint32_t)Harts.size();
+}
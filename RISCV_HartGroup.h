@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "RISCV_CPU.h"
+
+/**
+ * Several harts (RISCV_CPU contexts) running on one shared guest memory.
+ *
+ * Execution proceeds in quanta: every hart runs 'Quantum' instructions, then
+ * all harts meet at a barrier before the next quantum. In parallel mode each
+ * hart runs its quanta on its own host thread; in deterministic mode the
+ * harts take turns on the calling thread in hart order, so a run is exactly
+ * reproducible. Atomics (LR/SC, AMOs) use host atomics in both modes.
+ * The harts share one UART (a single console) and one CLINT, which holds an
+ * msip and mtimecmp per hart next to the common mtime.
+ */
+class RISCV_HartGroup {
+public:
+    RISCV_HartGroup(uint32_t numHarts, uint64_t quantum = DEFAULT_QUANTUM);
+
+    // Loads into the shared memory (every hart starts at PC 0 with a0 = hart id)
+    void LoadMemory(const std::vector<uint8_t>& programData, uint32_t startAddr);
+    void Reset();
+
+    // Runs every hart for up to 'instructionsPerHart'. Returns the total executed.
+    // Ends early when a hart hits a breakpoint or watchpoint (in parallel mode the other
+    // harts still finish their quantum) or once every hart has halted. GetStopInfo() and
+    // GetStoppedHart() say which hart stopped the run, and why.
+    uint64_t RunFor(uint64_t instructionsPerHart);
+    const StopInfo& GetStopInfo() const; // Reason is None when every hart ran to the end
+    uint32_t GetStoppedHart() const;
+
+    void SetQuantum(uint64_t quantum);
+    void SetDeterministic(bool deterministic);
+
+    RISCV_CPU& GetHart(uint32_t index);
+    uint32_t GetNumHarts() const;
+
+    static const uint64_t DEFAULT_QUANTUM = 10000;
+
+private:
+    uint64_t RunParallel(uint64_t instructionsPerHart);
+    uint64_t RunDeterministic(uint64_t instructionsPerHart);
+    bool AllHalted() const;
+
+    std::shared_ptr<GuestMemory> Memory;
+    std::shared_ptr<RISCV_UART> Uart;
+    std::shared_ptr<RISCV_CLINT> Clint;
+    std::vector<std::unique_ptr<RISCV_CPU>> Harts;
+    uint64_t Quantum;
+    bool bDeterministic;
+
+    StopInfo Stop;
+    uint32_t StoppedHart;
+};
@@ -0,0 +1,100 @@
+#include "RISCV_MappedFile.h"
+
+#if defined(_WIN32)
+// Through the engine's wrapper, which keeps windows.h macros out of the rest of the build
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RISCV_MappedFile::RISCV_MappedFile() {
+    Data = nullptr;
+    Size = 0;
+#if defined(_WIN32)
+    FileHandle = nullptr;
+    MappingHandle = nullptr;
+#endif
+}
+
+RISCV_MappedFile::~RISCV_MappedFile() {
+    Close();
+}
+
+bool RISCV_MappedFile::Open(const std::string& path) {
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    FileHandle = file;
+    MappingHandle = mapping;
+    Data = static_cast<const uint8_t*>(view);
+    Size = (size_t)size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file alive, so the descriptor is not needed afterwards
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    Data = static_cast<const uint8_t*>(view);
+    Size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void RISCV_MappedFile::Close() {
+    if (!Data) return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(Data);
+    CloseHandle((HANDLE)MappingHandle);
+    CloseHandle((HANDLE)FileHandle);
+    FileHandle = nullptr;
+    MappingHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(Data), Size);
+#endif
+    Data = nullptr;
+    Size = 0;
+}
+
+bool RISCV_MappedFile::IsOpen() const {
+    return Data != nullptr;
+}
+
+const uint8_t* RISCV_MappedFile::GetData() const {
+    return Data;
+}
+
+size_t RISCV_MappedFile::GetSize() const {
+    return Size;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file (mmap on POSIX, a file mapping on
+ * Windows). Pages are read from disk by the OS on first touch, so opening a
+ * large file costs nothing until its contents are used.
+ */
+class RISCV_MappedFile {
+public:
+    RISCV_MappedFile();
+    ~RISCV_MappedFile();
+    RISCV_MappedFile(const RISCV_MappedFile&) = delete;
+    RISCV_MappedFile& operator=(const RISCV_MappedFile&) = delete;
+
+    bool Open(const std::string& path); // Closes any previous mapping first
+    void Close();
+
+    bool IsOpen() const;
+    const uint8_t* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const uint8_t* Data;
+    size_t Size;
+#if defined(_WIN32)
+    void* FileHandle;
+    void* MappingHandle;
+#endif
+};
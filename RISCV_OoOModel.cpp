@@ -0,0 +1,393 @@
+#include "RISCV_OoOModel.h"
+#include <algorithm>
+
+void RISCV_OoOModel::History::Init(uint32_t minCapacity) {
+    uint64_t capacity = 1;
+    while (capacity < minCapacity + 1) capacity <<= 1;
+
+    Values.assign(capacity, 0);
+    Mask = capacity - 1;
+    Count = 0;
+}
+
+RISCV_OoOModel::RISCV_OoOModel(const OoOConfig& config) {
+    Config = config;
+
+    // Guard against configurations that could never make progress
+    Config.FetchWidth = std::max(Config.FetchWidth, 1u);
+    Config.IssueWidth = std::max(Config.IssueWidth, 1u);
+    Config.CommitWidth = std::max(Config.CommitWidth, 1u);
+    Config.ROBSize = std::max(Config.ROBSize, 1u);
+    Config.IQSize = std::max(Config.IQSize, 1u);
+    Config.LoadQueueSize = std::max(Config.LoadQueueSize, 1u);
+    Config.StoreQueueSize = std::max(Config.StoreQueueSize, 1u);
+    Config.PhysRegs = std::max(Config.PhysRegs, 33u);
+    Config.NumALUs = std::max(Config.NumALUs, 1u);
+    Config.NumBranchUnits = std::max(Config.NumBranchUnits, 1u);
+    Config.NumMemPorts = std::max(Config.NumMemPorts, 1u);
+
+    Reset();
+}
+
+void RISCV_OoOModel::Reset() {
+    Stats = OoOStats();
+
+    ROBCommit.Init(Config.ROBSize);
+    IQIssue.Init(Config.IQSize);
+    LoadCommit.Init(Config.LoadQueueSize);
+    StoreCommit.Init(Config.StoreQueueSize);
+    RegCommit.Init(Config.PhysRegs - 32);
+
+    for (int i = 0; i < 32; i++) {
+        RegReady[i] = 0;
+        FRegReady[i] = 0;
+    }
+
+    StoreAddrTag.assign(1u << STORE_TABLE_BITS, 0xFFFFFFFF);
+    StoreReady.assign(1u << STORE_TABLE_BITS, 0);
+
+    Calendar.assign(CALENDAR_SIZE, IssueSlot{ UINT64_MAX, 0, { 0, 0, 0 } });
+
+    BranchCounters.assign(1u << Config.BranchPredictorBits, 1); // Weakly not-taken
+    IndirectTargets.assign(1u << Config.BranchPredictorBits, 0);
+    ReturnStack.clear();
+
+    FetchCycle = 0;
+    FetchedThisCycle = 0;
+    RedirectCycle = 0;
+    RenameCycle = 0;
+    RenamedThisCycle = 0;
+    CommitCycle = 0;
+    CommittedThisCycle = 0;
+}
+
+uint64_t RISCV_OoOModel::Run(RISCV_CPU& cpu, uint64_t maxInstructions) {
+    uint64_t n = 0;
+    for (; n < maxInstructions; n++) {
+        if (cpu.IsHalted()) break; // ECALL/EBREAK with no handler ended the program
+
+        uint32_t pc = cpu.GetPC();
+        DecodedInstruction decoded = cpu.Decode(cpu.FetchInstruction());
+
+        // Effective address for loads/stores, read before Execute can change rs1
+        // (AMOs and vector accesses have no offset; their immediate bits mean something else)
+        uint32_t mem_addr = cpu.GetRegisterValue(decoded.rs1);
+        if (decoded.opcode != (uint32_t)OpcodeType::AMO && !IsVectorMemory(decoded)) mem_addr += decoded.imm;
+
+        cpu.Execute(decoded);
+        Retire(pc, decoded, mem_addr, cpu.GetPC());
+    }
+    return n;
+}
+
+bool RISCV_OoOModel::IsVectorMemory(const DecodedInstruction& inst) {
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+    return (op == OpcodeType::LOAD_FP || op == OpcodeType::STORE_FP) && inst.funct3 != 0x2 && inst.funct3 != 0x3;
+}
+
+RISCV_OoOModel::Operands RISCV_OoOModel::GetOperands(const DecodedInstruction& inst) {
+    switch (static_cast<OpcodeType>(inst.opcode)) {
+        case OpcodeType::LUI:
+        case OpcodeType::AUIPC:
+        case OpcodeType::JAL:
+            return { REG_X, REG_NONE, REG_NONE, REG_NONE };
+
+        case OpcodeType::JALR:
+        case OpcodeType::LOAD:
+        case OpcodeType::OP_IMM:
+            return { REG_X, REG_X, REG_NONE, REG_NONE };
+
+        case OpcodeType::OP:
+        case OpcodeType::AMO:
+            return { REG_X, REG_X, REG_X, REG_NONE };
+
+        case OpcodeType::BRANCH:
+        case OpcodeType::STORE:
+            return { REG_NONE, REG_X, REG_X, REG_NONE };
+
+        case OpcodeType::SYSTEM: // CSR*I take an immediate in the rs1 field
+            return { REG_X, (inst.funct3 & 0x4) ? REG_NONE : REG_X, REG_NONE, REG_NONE };
+
+        case OpcodeType::LOAD_FP:
+        case OpcodeType::STORE_FP: {
+            bool is_load = inst.opcode == (uint32_t)OpcodeType::LOAD_FP;
+            if (IsVectorMemory(inst)) {
+                bool strided = ((inst.raw >> 26) & 0x3) == 0x2; // rs2 holds the stride
+                return { REG_NONE, REG_X, strided ? REG_X : REG_NONE, REG_NONE };
+            }
+            return is_load ? Operands{ REG_F, REG_X, REG_NONE, REG_NONE } : Operands{ REG_NONE, REG_X, REG_F, REG_NONE };
+        }
+
+        case OpcodeType::MADD:
+        case OpcodeType::MSUB:
+        case OpcodeType::NMSUB:
+        case OpcodeType::NMADD:
+            return { REG_F, REG_F, REG_F, REG_F };
+
+        case OpcodeType::OP_FP:
+            switch (inst.funct7 >> 2) {
+                case 0x14: return { REG_X, REG_F, REG_F, REG_NONE };    // FEQ / FLT / FLE
+                case 0x18:                                               // FCVT.W(U)
+                case 0x1C: return { REG_X, REG_F, REG_NONE, REG_NONE };  // FMV.X.W / FCLASS
+                case 0x1A:                                               // FCVT.S.W(U)
+                case 0x1E: return { REG_F, REG_X, REG_NONE, REG_NONE };  // FMV.W.X
+                case 0x08:                                               // FCVT.S.D / FCVT.D.S
+                case 0x0B: return { REG_F, REG_F, REG_NONE, REG_NONE };  // FSQRT
+                default:   return { REG_F, REG_F, REG_F, REG_NONE };
+            }
+
+        case OpcodeType::OP_V:
+            switch (inst.funct3) {
+                case 0x7: { // vsetvli / vsetivli (uimm in rs1) / vsetvl (vtype in rs2)
+                    bool is_vsetivli = (inst.raw >> 30) == 0x3;
+                    bool is_vsetvl = (inst.raw >> 30) == 0x2;
+                    return { REG_X, is_vsetivli ? REG_NONE : REG_X, is_vsetvl ? REG_X : REG_NONE, REG_NONE };
+                }
+                case 0x2: // OPMVV: only vmv.x.s leaves the vector unit
+                    return { ((inst.raw >> 26) == 0x10) ? REG_X : REG_NONE, REG_NONE, REG_NONE, REG_NONE };
+                case 0x4: // OPIVX
+                case 0x6: // OPMVX
+                    return { REG_NONE, REG_X, REG_NONE, REG_NONE };
+                case 0x5: // OPFVF
+                    return { REG_NONE, REG_F, REG_NONE, REG_NONE };
+                default:
+                    return { REG_NONE, REG_NONE, REG_NONE, REG_NONE };
+            }
+
+        default:
+            return { REG_NONE, REG_NONE, REG_NONE, REG_NONE };
+    }
+}
+
+uint64_t RISCV_OoOModel::FindIssueCycle(uint64_t ready, FUClass unit) {
+    const uint32_t units[FU_COUNT] = { Config.NumALUs, Config.NumBranchUnits, Config.NumMemPorts };
+
+    // Walk forward from the ready cycle until an issue slot and a unit are free.
+    // The calendar is a ring, so instructions more than CALENDAR_SIZE cycles
+    // apart simply stop seeing each other's reservations.
+    for (uint64_t cycle = ready; ; cycle++) {
+        IssueSlot& slot = Calendar[cycle & (CALENDAR_SIZE - 1)];
+        if (slot.Cycle != cycle) {
+            slot = IssueSlot{ cycle, 0, { 0, 0, 0 } };
+        }
+
+        if (slot.Issued < Config.IssueWidth && slot.Busy[unit] < units[unit]) {
+            slot.Issued++;
+            slot.Busy[unit]++;
+            return cycle;
+        }
+    }
+}
+
+bool RISCV_OoOModel::PredictBranch(uint32_t pc, const DecodedInstruction& inst, uint32_t nextPC) {
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+    uint32_t index = (pc >> 2) & ((1u << Config.BranchPredictorBits) - 1);
+    bool is_call = (inst.rd == 1 || inst.rd == 5);
+    bool correct = true;
+
+    switch (op) {
+        case OpcodeType::JAL:
+            // Direct target, always found in the BTB
+            break;
+
+        case OpcodeType::JALR:
+            if (inst.rd == 0 && (inst.rs1 == 1 || inst.rs1 == 5)) {
+                // Return: predicted by the return address stack
+                correct = !ReturnStack.empty() && ReturnStack.back() == nextPC;
+                if (!ReturnStack.empty()) ReturnStack.pop_back();
+            } else {
+                correct = IndirectTargets[index] == nextPC;
+                IndirectTargets[index] = nextPC;
+            }
+            break;
+
+        case OpcodeType::BRANCH: {
+            bool taken = nextPC != pc + 4;
+            uint8_t& counter = BranchCounters[index];
+            correct = (counter >= 2) == taken;
+            if (taken && counter < 3) counter++;
+            if (!taken && counter > 0) counter--;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    if ((op == OpcodeType::JAL || op == OpcodeType::JALR) && is_call) {
+        if (ReturnStack.size() == 16) ReturnStack.erase(ReturnStack.begin());
+        ReturnStack.push_back(pc + 4);
+    }
+    return correct;
+}
+
+void RISCV_OoOModel::Retire(uint32_t pc, const DecodedInstruction& inst, uint32_t memAddr, uint32_t nextPC) {
+    OpcodeType op = static_cast<OpcodeType>(inst.opcode);
+    Operands operands = GetOperands(inst);
+
+    // LR is a load; SC and the AMOs take a store queue entry and return a value like a load
+    bool is_amo = (op == OpcodeType::AMO);
+    bool is_load = (op == OpcodeType::LOAD || op == OpcodeType::LOAD_FP || (is_amo && (inst.funct7 >> 2) == 0x02));
+    bool is_store = (op == OpcodeType::STORE || op == OpcodeType::STORE_FP || (is_amo && (inst.funct7 >> 2) != 0x02));
+    bool is_control = (op == OpcodeType::BRANCH || op == OpcodeType::JAL || op == OpcodeType::JALR);
+    bool writes_x = operands.Rd == REG_X && inst.rd != 0;
+    bool writes_f = operands.Rd == REG_F;
+
+    auto operand_ready = [this](RegFile file, uint32_t reg) -> uint64_t {
+        if (file == REG_X) return RegReady[reg];
+        if (file == REG_F) return FRegReady[reg];
+        return 0;
+    };
+
+    Stats.Instructions++;
+
+    // ==========================================================
+    // 1. FETCH (in order, FetchWidth per cycle)
+    // ==========================================================
+    if (FetchCycle < RedirectCycle) {
+        Stats.StallMispredict += RedirectCycle - FetchCycle;
+        FetchCycle = RedirectCycle;
+        FetchedThisCycle = 0;
+    }
+    if (FetchedThisCycle == Config.FetchWidth) {
+        FetchCycle++;
+        FetchedThisCycle = 0;
+    }
+    uint64_t fetch = FetchCycle;
+    FetchedThisCycle++;
+
+    // A taken control transfer ends the fetch group
+    if (nextPC != pc + 4) {
+        FetchCycle++;
+        FetchedThisCycle = 0;
+    }
+
+    // ==========================================================
+    // 2. RENAME / DISPATCH (in order, needs a free entry everywhere it goes)
+    // ==========================================================
+    uint64_t dispatch = std::max(fetch + Config.FrontendDepth, RenameCycle);
+
+    auto wait_for = [&dispatch](uint64_t freeAt, uint64_t& stallCounter) {
+        if (freeAt > dispatch) {
+            stallCounter += freeAt - dispatch;
+            dispatch = freeAt;
+        }
+    };
+
+    wait_for(ROBCommit.Ago(Config.ROBSize), Stats.StallROBFull);
+    // Issue queue entries are freed out of order; the instruction IQSize back is a good stand-in
+    wait_for(IQIssue.Ago(Config.IQSize) + 1, Stats.StallIQFull);
+    if (is_load) wait_for(LoadCommit.Ago(Config.LoadQueueSize), Stats.StallLoadQueueFull);
+    if (is_store) wait_for(StoreCommit.Ago(Config.StoreQueueSize), Stats.StallStoreQueueFull);
+    if (writes_x) wait_for(RegCommit.Ago(Config.PhysRegs - 32), Stats.StallNoFreeRegs);
+
+    if (dispatch == RenameCycle && RenamedThisCycle == Config.FetchWidth) {
+        dispatch++;
+    }
+    if (dispatch > RenameCycle) {
+        RenameCycle = dispatch;
+        RenamedThisCycle = 0;
+    }
+    RenamedThisCycle++;
+
+    // ==========================================================
+    // 3. ISSUE (out of order, once operands are ready and a unit is free)
+    // ==========================================================
+    uint64_t ready = dispatch + 1;
+    ready = std::max(ready, operand_ready(operands.Rs1, inst.rs1));
+    ready = std::max(ready, operand_ready(operands.Rs2, inst.rs2));
+    ready = std::max(ready, operand_ready(operands.Rs3, inst.raw >> 27));
+
+    uint32_t store_index = (memAddr >> 2) & ((1u << STORE_TABLE_BITS) - 1);
+    if ((is_load || is_amo) && StoreAddrTag[store_index] == (memAddr >> 2)) {
+        // Store-to-load forwarding: wait for the older store's data
+        ready = std::max(ready, StoreReady[store_index]);
+    }
+    Stats.StallOperands += ready - (dispatch + 1);
+
+    FUClass unit = is_control ? FU_BRANCH : ((is_load || is_store) ? FU_MEM : FU_ALU);
+    uint64_t issue = FindIssueCycle(ready, unit);
+    Stats.StallFunctionUnit += issue - ready;
+    IQIssue.Push(issue);
+
+    uint32_t latency = Config.ALULatency;
+    if (is_control) latency = Config.BranchLatency;
+    if (is_load)    latency = Config.LoadLatency;
+    if (is_store)   latency = is_amo ? Config.LoadLatency : Config.StoreLatency;
+    uint64_t complete = issue + latency;
+
+    if (writes_x) {
+        RegReady[inst.rd] = complete;
+    }
+    if (writes_f) {
+        FRegReady[inst.rd] = complete;
+    }
+    if (is_store) {
+        StoreAddrTag[store_index] = memAddr >> 2;
+        StoreReady[store_index] = complete;
+    }
+
+    // ==========================================================
+    // 4. BRANCH RESOLUTION
+    // ==========================================================
+    if (is_control) {
+        Stats.Branches++;
+        if (!PredictBranch(pc, inst, nextPC)) {
+            Stats.Mispredicts++;
+            RedirectCycle = std::max(RedirectCycle, complete + Config.MispredictPenalty);
+        }
+    }
+
+    // ==========================================================
+    // 5. COMMIT (in order, CommitWidth per cycle)
+    // ==========================================================
+    uint64_t commit = std::max(complete + 1, CommitCycle);
+    if (commit == CommitCycle && CommittedThisCycle == Config.CommitWidth) {
+        commit++;
+        Stats.StallCommitWidth++;
+    }
+    if (commit > CommitCycle) {
+        CommitCycle = commit;
+        CommittedThisCycle = 0;
+    }
+    CommittedThisCycle++;
+
+    ROBCommit.Push(commit);
+    if (is_load) {
+        Stats.Loads++;
+        LoadCommit.Push(commit);
+    }
+    if (is_store) {
+        Stats.Stores++;
+        StoreCommit.Push(commit);
+    }
+    if (writes_x) {
+        RegCommit.Push(commit);
+    }
+
+    Stats.Cycles = CommitCycle + 1;
+}
+
+const OoOStats& RISCV_OoOModel::GetStats() const {
+    return Stats;
+}
+
+void RISCV_OoOModel::PrintReport(std::ostream& out) const {
+    out << "--- Out-of-Order Model Report ---" << std::endl;
+    out << "Instructions: " << Stats.Instructions << std::endl;
+    out << "Cycles:       " << Stats.Cycles << std::endl;
+    out << "IPC:          " << Stats.GetIPC() << std::endl;
+    out << "Branches:     " << Stats.Branches << " (" << Stats.Mispredicts << " mispredicted)" << std::endl;
+    out << "Loads/Stores: " << Stats.Loads << " / " << Stats.Stores << std::endl;
+    out << "Stall cycles by cause:" << std::endl;
+    out << "  ROB full:          " << Stats.StallROBFull << std::endl;
+    out << "  Issue queue full:  " << Stats.StallIQFull << std::endl;
+    out << "  Load queue full:   " << Stats.StallLoadQueueFull << std::endl;
+    out << "  Store queue full:  " << Stats.StallStoreQueueFull << std::endl;
+    out << "  No free registers: " << Stats.StallNoFreeRegs << std::endl;
+    out << "  Mispredict refill: " << Stats.StallMispredict << std::endl;
+    out << "  Operand wait:      " << Stats.StallOperands << std::endl;
+    out << "  Function unit:     " << Stats.StallFunctionUnit << std::endl;
+    out << "  Commit width:      " << Stats.StallCommitWidth << std::endl;
+    out << "---------------------------------" << std::endl;
+}
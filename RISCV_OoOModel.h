@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "RISCV_CPU.h"
+
+/**
+ * Knobs for the out-of-order timing model.
+ * Sizes do not need to be powers of two.
+ */
+struct OoOConfig {
+    // Pipeline widths (instructions per cycle)
+    uint32_t FetchWidth  = 4;
+    uint32_t IssueWidth  = 4;
+    uint32_t CommitWidth = 4;
+
+    // Window resources
+    uint32_t ROBSize       = 128; // Reorder buffer entries
+    uint32_t IQSize        = 48;  // Issue queue entries
+    uint32_t LoadQueueSize = 32;
+    uint32_t StoreQueueSize = 24;
+    uint32_t PhysRegs      = 128; // Physical integer registers (32 hold architectural state; f registers rename separately)
+
+    // Functional units
+    uint32_t NumALUs     = 3;
+    uint32_t NumBranchUnits = 1;
+    uint32_t NumMemPorts = 2;
+
+    // Latencies (cycles)
+    uint32_t FrontendDepth     = 3;  // Fetch -> rename
+    uint32_t ALULatency        = 1;
+    uint32_t BranchLatency     = 1;
+    uint32_t LoadLatency       = 3;
+    uint32_t StoreLatency      = 1;
+    uint32_t MispredictPenalty = 8;  // Extra cycles to refill the front end after a redirect
+
+    // Bimodal branch predictor: 2^BranchPredictorBits 2-bit counters
+    uint32_t BranchPredictorBits = 12;
+};
+
+/**
+ * What the model reports. Stall counters are the cycles by which each cause
+ * delayed an instruction beyond where it would otherwise have been.
+ */
+struct OoOStats {
+    uint64_t Instructions = 0;
+    uint64_t Cycles = 0;
+    uint64_t Branches = 0;
+    uint64_t Mispredicts = 0;
+    uint64_t Loads = 0;
+    uint64_t Stores = 0;
+
+    // Stall causes
+    uint64_t StallROBFull = 0;
+    uint64_t StallIQFull = 0;
+    uint64_t StallLoadQueueFull = 0;
+    uint64_t StallStoreQueueFull = 0;
+    uint64_t StallNoFreeRegs = 0;
+    uint64_t StallMispredict = 0;
+    uint64_t StallOperands = 0;     // Waiting in the issue queue for source values
+    uint64_t StallFunctionUnit = 0; // Ready, but no issue slot or unit free
+    uint64_t StallCommitWidth = 0;
+
+    double GetIPC() const { return Cycles ? (double)Instructions / (double)Cycles : 0.0; }
+};
+
+/**
+ * Trace-driven out-of-order superscalar timing model.
+ *
+ * RISCV_CPU::Execute still does all the functional work. The model only
+ * sees each retired instruction (PC, fields, memory address, next PC) and
+ * works out in which cycle it would be fetched, renamed, issued, completed
+ * and committed on the configured machine. All per-instruction state is
+ * kept in fixed-size ring buffers indexed by sequence number, so nothing is
+ * allocated after construction and the working set stays in L1/L2.
+ */
+class RISCV_OoOModel {
+public:
+    explicit RISCV_OoOModel(const OoOConfig& config = OoOConfig());
+
+    void Reset();
+
+    // Runs the CPU functionally and feeds every instruction into the model.
+    // Stops early if the program halts; returns the number of instructions run.
+    uint64_t Run(RISCV_CPU& cpu, uint64_t maxInstructions);
+
+    // Feed one retired instruction (for callers that drive the CPU themselves)
+    void Retire(uint32_t pc, const DecodedInstruction& inst, uint32_t memAddr, uint32_t nextPC);
+
+    const OoOStats& GetStats() const;
+    void PrintReport(std::ostream& out) const;
+
+private:
+    // Unit classes that compete for issue
+    enum FUClass { FU_ALU = 0, FU_BRANCH = 1, FU_MEM = 2, FU_COUNT = 3 };
+
+    // Register file each operand of an instruction lives in (vector registers are not tracked)
+    enum RegFile : uint8_t { REG_NONE, REG_X, REG_F };
+    struct Operands {
+        RegFile Rd, Rs1, Rs2, Rs3;
+    };
+    static Operands GetOperands(const DecodedInstruction& inst);
+    static bool IsVectorMemory(const DecodedInstruction& inst);
+
+    /**
+     * Last N values of a per-instruction quantity, indexed by sequence number.
+     * Capacity is rounded up to a power of two so lookups are a mask.
+     */
+    struct History {
+        std::vector<uint64_t> Values;
+        uint64_t Mask = 0;
+        uint64_t Count = 0;
+
+        void Init(uint32_t minCapacity);
+        void Push(uint64_t v) { Values[Count & Mask] = v; Count++; }
+        // The value pushed 'back' entries ago (0 if there was none)
+        uint64_t Ago(uint32_t back) const { return back <= Count ? Values[(Count - back) & Mask] : 0; }
+    };
+
+    // One slot of the issue calendar: how many units of each class are busy in a cycle
+    struct IssueSlot {
+        uint64_t Cycle;
+        uint8_t Issued;
+        uint8_t Busy[FU_COUNT];
+    };
+
+    uint64_t FindIssueCycle(uint64_t ready, FUClass unit);
+    bool PredictBranch(uint32_t pc, const DecodedInstruction& inst, uint32_t nextPC);
+
+    OoOConfig Config;
+    OoOStats Stats;
+
+    // Window occupancy - an entry can be reused once the instruction N back has left it
+    History ROBCommit;    // Commit cycle of recent instructions
+    History IQIssue;      // Issue cycle of recent instructions
+    History LoadCommit;   // Commit cycle of recent loads
+    History StoreCommit;  // Commit cycle of recent stores
+    History RegCommit;    // Commit cycle of recent register writers (frees a physical register)
+
+    // Rename tables: cycle at which each architectural register's newest value is ready
+    uint64_t RegReady[32];
+    uint64_t FRegReady[32];
+
+    // Store-to-load dependences, tracked per word in a direct-mapped table
+    static const uint32_t STORE_TABLE_BITS = 10;
+    std::vector<uint32_t> StoreAddrTag;
+    std::vector<uint64_t> StoreReady;
+
+    // Issue calendar (ring indexed by cycle)
+    static const uint32_t CALENDAR_SIZE = 1024;
+    std::vector<IssueSlot> Calendar;
+
+    // Branch prediction
+    std::vector<uint8_t> BranchCounters; // 2-bit saturating counters
+    std::vector<uint32_t> IndirectTargets; // Last target seen per JALR
+    std::vector<uint32_t> ReturnStack;
+
+    // Front end / rename / commit cursors
+    uint64_t FetchCycle;
+    uint32_t FetchedThisCycle;
+    uint64_t RedirectCycle;
+    uint64_t RenameCycle;
+    uint32_t RenamedThisCycle;
+    uint64_t CommitCycle;
+    uint32_t CommittedThisCycle;
+};
@@ -0,0 +1,140 @@
+#include "RISCV_PredecodeCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static_assert(sizeof(DecodedInstruction) % 4 == 0, "Records are read in place from the mapped file");
+
+RISCV_PredecodeCache::RISCV_PredecodeCache() {
+    Entries = nullptr;
+    Base = 0;
+    Count = 0;
+    ImageSize = 0;
+    ImageHash = 0;
+}
+
+bool RISCV_PredecodeCache::Open(const std::vector<uint8_t>& image, uint32_t startAddr, const std::string& cacheDir) {
+    File.Close();
+    Built.clear();
+    Entries = nullptr;
+    Count = 0;
+
+    if (startAddr & 0x3) {
+        std::cerr << "Error: Predecoded Image Not Word Aligned at " << std::hex << startAddr << std::endl;
+        return false;
+    }
+    if (startAddr >= RISCV_CPU::MEMORY_SIZE) {
+        std::cerr << "Error: Predecoded Image Out of Memory at " << std::hex << startAddr << std::endl;
+        return false;
+    }
+    // Key on exactly what LoadMemory keeps, so Attach can compare the segment's stored hash
+    Base = startAddr;
+    ImageSize = (uint32_t)std::min<size_t>(image.size(), RISCV_CPU::MEMORY_SIZE - startAddr);
+    ImageHash = RISCV_CPU::HashImage(image.data(), ImageSize, startAddr);
+
+    std::string path;
+    if (!cacheDir.empty()) {
+        std::ostringstream name;
+        name << cacheDir << '/' << std::hex << std::setw(16) << std::setfill('0') << ImageHash << ".rvpd";
+        path = name.str();
+        if (Load(path)) return true;
+    }
+
+    // Not cached (or stale): decode every word, so any block the program reaches is covered
+    Built.resize(ImageSize / 4);
+    for (size_t i = 0; i < Built.size(); i++) {
+        const uint8_t* word = &image[i * 4];
+        uint32_t inst = (uint32_t)word[0] | ((uint32_t)word[1] << 8) | ((uint32_t)word[2] << 16) | ((uint32_t)word[3] << 24);
+        Built[i] = RISCV_CPU::Decode(inst);
+    }
+    Entries = Built.data();
+    Count = (uint32_t)Built.size();
+
+    if (!path.empty() && !Save(path)) {
+        std::cerr << "Warning: Could not write predecode cache " << path << std::endl;
+    }
+    return true;
+}
+
+bool RISCV_PredecodeCache::Load(const std::string& path) {
+    if (!File.Open(path)) return false;
+
+    // Anything that does not match exactly is treated as a miss and rebuilt
+    FileHeader header;
+    bool valid = File.GetSize() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, File.GetData(), sizeof(header));
+        valid = header.Magic == FILE_MAGIC && header.Version == FILE_VERSION && header.ImageHash == ImageHash &&
+                header.EntrySize == sizeof(DecodedInstruction) && header.Base == Base &&
+                header.ImageSize == ImageSize && header.Count == ImageSize / 4 &&
+                File.GetSize() == sizeof(header) + (size_t)header.Count * sizeof(DecodedInstruction);
+    }
+    if (!valid) {
+        File.Close();
+        return false;
+    }
+
+    // Executed in place: only the pages of the table the program reaches are read from disk
+    Entries = reinterpret_cast<const DecodedInstruction*>(File.GetData() + sizeof(header));
+    Count = header.Count;
+    return true;
+}
+
+bool RISCV_PredecodeCache::Save(const std::string& path) const {
+    FileHeader header = {};
+    header.Magic = FILE_MAGIC;
+    header.Version = FILE_VERSION;
+    header.ImageHash = ImageHash;
+    header.EntrySize = sizeof(DecodedInstruction);
+    header.Base = Base;
+    header.Count = Count;
+    header.ImageSize = ImageSize;
+
+    // Write a temporary file and rename it over the old one, so a concurrent run never maps a partial file
+    std::string temp_path = path + ".tmp";
+    std::error_code error;
+    bool written;
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(Entries), (std::streamsize)Count * sizeof(DecodedInstruction));
+        out.close();
+        written = !out.fail();
+    }
+    if (written) {
+        std::filesystem::rename(temp_path, path, error);
+        if (!error) return true;
+    }
+    std::filesystem::remove(temp_path, error);
+    return false;
+}
+
+bool RISCV_PredecodeCache::Attach(RISCV_CPU& cpu) const {
+    // Only attach to the image this was opened for, or RunFor would execute stale instructions
+    if (Entries) {
+        for (const GuestMemory::ImageSegment& segment : cpu.GetSharedMemory()->LoadedImage) {
+            if (segment.StartAddr == Base && segment.Bytes.size() == ImageSize && segment.Hash == ImageHash) {
+                cpu.AttachPredecoded(Entries, Base, Count);
+                return true;
+            }
+        }
+    }
+
+    std::cerr << "Error: Predecoded Image at " << std::hex << Base << " Does Not Match the Loaded Image" << std::endl;
+    return false;
+}
+
+bool RISCV_PredecodeCache::IsFromDisk() const {
+    return File.IsOpen();
+}
+
+uint64_t RISCV_PredecodeCache::GetImageHash() const {
+    return ImageHash;
+}
+
+uint32_t RISCV_PredecodeCache::GetCount() const {
+    return Count;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RISCV_CPU.h"
+#include "RISCV_MappedFile.h"
+
+/**
+ * Ahead-of-time predecoded form of a guest image, persisted on disk.
+ *
+ * Every word of the image is decoded once into a DecodedInstruction, which
+ * covers every basic block the program can reach, indirect jumps included.
+ * The table is saved under the image's RISCV_CPU::HashImage key, so later runs
+ * of the same binary just map the file and RunFor executes from it straight
+ * away, with no fetch or decode for code that has not been overwritten.
+ *
+ * The key is the one LoadMemory already computes for each segment, so looking
+ * up and attaching a saved table costs one fast hash of the image (well under
+ * a tenth of the time it takes to decode it) and no further pass at all.
+ *
+ * File layout: a FileHeader followed by Count DecodedInstruction records,
+ * in host byte order (the file is a cache, not an interchange format).
+ */
+class RISCV_PredecodeCache {
+public:
+    RISCV_PredecodeCache();
+
+    // Makes the predecoded form of 'image' (as given to RISCV_CPU::LoadMemory) available.
+    // Maps "<cacheDir>/<hash>.rvpd" if it exists and matches, otherwise predecodes the
+    // image and writes that file for next time. An empty cacheDir keeps it in memory only.
+    bool Open(const std::vector<uint8_t>& image, uint32_t startAddr, const std::string& cacheDir);
+
+    // Call after LoadMemory (which detaches). Refuses unless the CPU's loaded image has a
+    // segment at the same address with the same size and hash. The cache must outlive the attachment.
+    bool Attach(RISCV_CPU& cpu) const;
+
+    bool IsFromDisk() const; // The last Open mapped an existing file
+    uint64_t GetImageHash() const;
+    uint32_t GetCount() const;
+
+private:
+    struct FileHeader {
+        uint32_t Magic;     // FILE_MAGIC
+        uint32_t Version;   // FILE_VERSION
+        uint64_t ImageHash; // RISCV_CPU::HashImage
+        uint32_t EntrySize; // sizeof(DecodedInstruction) when written
+        uint32_t Base;
+        uint32_t Count;
+        uint32_t ImageSize; // In bytes
+    };
+    static const uint32_t FILE_MAGIC = 0x44505652; // "RVPD"
+    static const uint32_t FILE_VERSION = 2;
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+    RISCV_MappedFile File;                 // Backing store when loaded from disk
+    std::vector<DecodedInstruction> Built; // Backing store when predecoded here
+    const DecodedInstruction* Entries;
+    uint32_t Base;
+    uint32_t Count;
+    uint32_t ImageSize;
+    uint64_t ImageHash;
+};
@@ -229,6 +229,7 @@ void ARISCV_Processor::ExecuteAndDisplay(DecodedInstruction& Decoded)
 {
     FloatingInfoText->SetText(FText::FromString(CpuCore.Disassemble(Decoded)));
     CpuCore.Execute(Decoded);
+    CpuCore.GetUART().Flush();
     UpdateVisuals();
 }
 
@@ -257,12 +258,41 @@ void ARISCV_Processor::Step()
     ExecuteAndDisplay(decoded);
 }
 
+void ARISCV_Processor::StepBack()
+{
+    ResetRegisterMaterials();
+
+    if (CpuCore.StepBack(1) == 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("RISC-V: No more history to step back through."));
+        return;
+    }
+
+    // Show the instruction we just undid (it is the next one to run again)
+    DecodedInstruction decoded = CpuCore.Decode(CpuCore.FetchInstruction());
+    HighlightDestinationRegister(decoded);
+    FloatingInfoText->SetText(FText::FromString(FString::Printf(TEXT("<< %s"), *CpuCore.Disassemble(decoded))));
+    UpdateVisuals();
+}
+
 void ARISCV_Processor::ResetAndLoad()
 {
-    CpuCore = RISCV_CPU();
-    std::vector<uint8_t> memoryBytes;
-    Run_fibonacciProgram(memoryBytes); // put the program we want to run into memoryBytes
-    CpuCore.LoadMemory(memoryBytes, 0);
+    // Reset in place: only the memory pages the program wrote are restored
+    CpuCore.Reset();
+
+    if (!CpuCore.HasLoadedImage())
+    {
+        std::vector<uint8_t> memoryBytes;
+        Run_fibonacciProgram(memoryBytes); // put the program we want to run into memoryBytes
+        CpuCore.LoadMemory(memoryBytes, 0);
+    }
+    CpuCore.EnableUndoLog(true);
+
+    // Forward guest console output (UART) to the Output Log
+    CpuCore.GetUART().SetOutputSink([](const char* Data, size_t Len)
+    {
+        UE_LOG(LogTemp, Log, TEXT("RISC-V UART: %s"), *FString((int32)Len, Data));
+    });
     UE_LOG(LogTemp, Warning, TEXT("RISC-V: Fibonacci Program Loaded."));
 }
 
@@ -39,6 +39,9 @@ public:
     UFUNCTION(BlueprintCallable, Category = "RISC-V Control")
     void Step();
 
+    UFUNCTION(BlueprintCallable, Category = "RISC-V Control")
+    void StepBack();
+
     UFUNCTION(BlueprintCallable, Category = "RISC-V Control")
     void ResetAndLoad();
 
@@ -0,0 +1,106 @@
+#include "RISCV_UndoLog.h"
+
+RISCV_UndoLog::RISCV_UndoLog(size_t maxChunks) {
+    MaxChunks = maxChunks < 1 ? 1 : maxChunks;
+    EndIndex = 0;
+}
+
+bool RISCV_UndoLog::NeedsNewChunk() const {
+    return Chunks.empty() || Chunks.back().Records.size() == CHUNK_RECORDS || Chunks.back().Extra.size() >= CHUNK_EXTRA_BYTES;
+}
+
+UndoRecord& RISCV_UndoLog::Push(uint32_t pc) {
+    // Start a new chunk (a new checkpoint) when the current one is full
+    if (NeedsNewChunk()) {
+        if (Chunks.size() == MaxChunks) {
+            DropOldestChunk(); // Over budget: the oldest history is only reachable by replay now
+        }
+
+        if (!SpareChunks.empty()) {
+            Chunks.push_back(std::move(SpareChunks.back()));
+            SpareChunks.pop_back();
+            Chunks.back().Records.clear();
+            Chunks.back().Extra.clear();
+        } else {
+            Chunks.emplace_back();
+            Chunks.back().Records.reserve(CHUNK_RECORDS);
+        }
+    }
+
+    EndIndex++;
+    Chunks.back().Records.push_back({ pc, 0, 0, 0, 0, 0, 0 });
+    return Chunks.back().Records.back();
+}
+
+void RISCV_UndoLog::AppendExtra(const void* data, size_t size) {
+    Chunk& chunk = Chunks.back();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    chunk.Extra.insert(chunk.Extra.end(), bytes, bytes + size);
+    chunk.Records.back().ExtraSize = (uint16_t)(chunk.Records.back().ExtraSize + size);
+}
+
+UndoRecord RISCV_UndoLog::Pop(std::vector<uint8_t>& extra) {
+    Chunk& chunk = Chunks.back();
+    UndoRecord rec = chunk.Records.back();
+    chunk.Records.pop_back();
+
+    // A record's extra state is the newest part of its chunk's arena
+    extra.assign(chunk.Extra.end() - rec.ExtraSize, chunk.Extra.end());
+    chunk.Extra.resize(chunk.Extra.size() - rec.ExtraSize);
+
+    if (chunk.Records.empty()) {
+        SpareChunks.push_back(std::move(chunk));
+        Chunks.pop_back();
+    }
+    EndIndex--;
+    return rec;
+}
+
+bool RISCV_UndoLog::IsEmpty() const {
+    return Chunks.empty();
+}
+
+size_t RISCV_UndoLog::Size() const {
+    size_t size = 0;
+    for (const Chunk& chunk : Chunks) {
+        size += chunk.Records.size(); // Chunks can end early, once their extra arena is full
+    }
+    return size;
+}
+
+uint64_t RISCV_UndoLog::GetBeginIndex() const {
+    return EndIndex - Size();
+}
+
+uint64_t RISCV_UndoLog::GetEndIndex() const {
+    return EndIndex;
+}
+
+void RISCV_UndoLog::Clear(uint64_t endIndex) {
+    while (!Chunks.empty()) {
+        SpareChunks.push_back(std::move(Chunks.back()));
+        Chunks.pop_back();
+    }
+    EndIndex = endIndex;
+}
+
+void RISCV_UndoLog::DropOldestChunk() {
+    SpareChunks.push_back(std::move(Chunks.front()));
+    Chunks.pop_front();
+}
+
+void RISCV_UndoLog::SetMaxChunks(size_t maxChunks) {
+    MaxChunks = maxChunks < 1 ? 1 : maxChunks;
+
+    while (Chunks.size() > MaxChunks) {
+        DropOldestChunk();
+    }
+    // Do not hold on to more spare memory than the budget allows
+    if (SpareChunks.size() > MaxChunks) {
+        SpareChunks.resize(MaxChunks);
+    }
+}
+
+size_t RISCV_UndoLog::GetMaxChunks() const {
+    return MaxChunks;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * One executed instruction, recorded as just enough state to undo it.
+ * 20 bytes per instruction for the integer core. Instructions that change
+ * more (FP, vector and CSR state, traps, wide stores) also append ExtraSize
+ * bytes of saved state to their chunk (see RISCV_UndoLog::AppendExtra).
+ */
+struct UndoRecord {
+    uint32_t PrevPC;        // PC before the instruction ran
+    uint32_t PrevRdValue;   // Old value of rd (only valid if Rd != 0)
+    uint32_t StoreAddr;     // Address of the overwritten bytes (only valid if StoreSize != 0)
+    uint32_t StoreOldBytes; // The overwritten bytes, little endian
+    uint8_t  Rd;            // Register that was written (0 = none)
+    uint8_t  StoreSize;     // Bytes overwritten in RAM (0 = none)
+    uint16_t ExtraSize;     // Bytes of extra saved state
+};
+
+/**
+ * Chunked arena of UndoRecords, used for reverse execution.
+ *
+ * Records are appended into fixed-size chunks, and the owner takes a full
+ * checkpoint at the start of each one (NeedsNewChunk). Once the log holds more
+ * than MaxChunks chunks the oldest records are dropped, so memory use stays
+ * bounded, but their checkpoint is kept: older history is then reached by
+ * restoring it and replaying forward. Dropped chunks are kept for reuse, so
+ * steady-state recording does not allocate.
+ *
+ * Records are numbered from the start of the history: the log holds
+ * [GetBeginIndex(), GetEndIndex()).
+ */
+class RISCV_UndoLog {
+public:
+    RISCV_UndoLog(size_t maxChunks = DEFAULT_MAX_CHUNKS);
+
+    // True if the next Push starts a new chunk
+    bool NeedsNewChunk() const;
+
+    // Start a record for the instruction about to execute at 'pc'
+    UndoRecord& Push(uint32_t pc);
+
+    // Saves extra state for the newest record
+    void AppendExtra(const void* data, size_t size);
+
+    // Remove and return the newest record (the log must not be empty). Its extra
+    // state, if any, is copied to 'extra'.
+    UndoRecord Pop(std::vector<uint8_t>& extra);
+
+    bool IsEmpty() const;
+    size_t Size() const;
+    uint64_t GetBeginIndex() const;
+    uint64_t GetEndIndex() const;
+    void Clear(uint64_t endIndex = 0); // The next record gets 'endIndex'
+
+    void SetMaxChunks(size_t maxChunks);
+    size_t GetMaxChunks() const;
+
+    static const size_t CHUNK_RECORDS = 4096;
+    static const size_t CHUNK_EXTRA_BYTES = 256 * 1024; // A chunk also ends once this much extra state is saved
+    static const size_t DEFAULT_MAX_CHUNKS = 64;        // ~5 MB, ~260k instructions of history (integer code)
+
+private:
+    struct Chunk {
+        std::vector<UndoRecord> Records;
+        std::vector<uint8_t> Extra;
+    };
+
+    void DropOldestChunk();
+
+    std::deque<Chunk> Chunks;
+    std::vector<Chunk> SpareChunks;
+    size_t MaxChunks;
+    uint64_t EndIndex;
+};